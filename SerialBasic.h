@@ -7,10 +7,31 @@
 #include <boost/asio.hpp>
 #include <boost/system/error_code.hpp>
 #include <cstdint>
-#include <list>
 #include <sstream>
 #include <iterator>
 #include <memory>
+#include <cstring>
+#include <type_traits>
+#include <map>
+#include <functional>
+#include <cerrno>
+#include <chrono>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/version.hpp>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#define SERIAL_BASIC_HAS_MIRRORED_READ_BUFFER
+#endif
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define SERIAL_BASIC_HAS_MEMORY_RESOURCE
+#endif
+#endif
 
 /**
  * @file SerialBasic.h
@@ -39,9 +60,289 @@
  *          http://www.boost.org/LICENSE_1_0.txt)
  */
 
-template <class Type = uint8_t> class SerialBasic;
+/**
+ * \brief Compile-time storage configuration of a SerialBasic object
+ *
+ * Every buffer of a SerialBasic object is a fixed-size array sized by its configuration, thus a SerialBasic object does
+ * not allocate memory to read or write data. Smaller sizes can be selected for devices with little memory, and
+ * SerialBasic::inlineSize() can be checked with static_assert. That bounds the buffers, but not the memory the object
+ * allocates otherwise (see SerialBasic).
+ *
+ * @tparam ReadBufferSize The capacity in bytes of the buffer read() takes data from. Received data that does not fit
+ * is dropped.
+ * @tparam ReadTransferBufferSize The maximum amount of bytes received by a single asynchronous read.
+ * @tparam WriteBufferSize The capacity in bytes of the buffer in which write() stages data that is not already a
+ * contiguous array of Type.
+ * @tparam MirroredReadBuffer If true, the read buffer is a SerialBasicMirroredBuffer instead of an array, thus all
+ * buffered data is contiguous and data is received directly into the read buffer. Only available on POSIX operating
+ * systems, and ReadBufferSize must be a multiple of the page size.
+ * @tparam DecodedReadBuffer If true, the io service thread assembles complete items as data is received, carrying a
+ * partial item over to the next chunk, and the read buffer only ever holds whole items. read() then copies items
+ * without decoding them. Cannot be combined with MirroredReadBuffer, and the read buffer's capacity is rounded down to
+ * a multiple of sizeof(Type).
+ * @tparam DrainableReadBuffer If true, the SerialBasic object holds two read buffers, so that SerialBasic::drain() can
+ * hand off the whole content of one while data is received into the other.
+ */
+template <std::size_t ReadBufferSize = 512, std::size_t ReadTransferBufferSize = 128, std::size_t WriteBufferSize = 128,
+	bool MirroredReadBuffer = false, bool DecodedReadBuffer = false, bool DrainableReadBuffer = false>
+struct SerialBasicConfig {
+	const static std::size_t READ_BUFFER_SIZE = ReadBufferSize;
+	const static std::size_t READ_TRANSFER_BUFFER_SIZE = ReadTransferBufferSize;
+	const static std::size_t WRITE_BUFFER_SIZE = WriteBufferSize;
+	const static bool MIRRORED_READ_BUFFER = MirroredReadBuffer;
+	const static bool DECODED_READ_BUFFER = DecodedReadBuffer;
+	const static bool DRAINABLE_READ_BUFFER = DrainableReadBuffer;
+};
+
+/**
+ * \brief The read buffer of a SerialBasic object, stored in the object itself and aligned for the items
+ */
+template <std::size_t Size, bool Mirrored, std::size_t Alignment = 1>
+class SerialBasicReadBuffer {
+public:
+	uint8_t* data() {
+		return storage;
+	}
+private:
+	alignas(Alignment) uint8_t storage[Size];
+};
+
+#if defined(SERIAL_BASIC_HAS_MIRRORED_READ_BUFFER)
+/**
+ * \brief A ring buffer whose pages are mapped twice, back to back
+ *
+ * Byte i of the buffer is also found at byte i+Size, thus any Size bytes starting anywhere in the first mapping are
+ * contiguous, regardless of where the ring wraps. The pages are backed by an anonymous memfd on Linux, and by an
+ * immediately unlinked POSIX shared memory object on other POSIX operating systems.
+ */
+template <std::size_t Size, std::size_t Alignment>
+class SerialBasicReadBuffer<Size, true, Alignment> {
+public:
+
+	/**
+	 * \brief Map the buffer
+	 *
+	 * @throw boost::system::system_error Thrown if Size is not a multiple of the page size or mapping failed.
+	 */
+	SerialBasicReadBuffer() {
+		if (Size%(std::size_t)sysconf(_SC_PAGESIZE) != 0)
+			throw boost::system::system_error(boost::system::errc::make_error_code(
+				boost::system::errc::invalid_argument));
+#if defined(__linux__)
+		int descriptor = memfd_create("SerialBasic", 0);
+#else
+		std::stringstream ss;
+		ss << "/SerialBasic." << getpid() << "." << (const void*)this;
+		int descriptor = shm_open(ss.str().c_str(), O_RDWR|O_CREAT|O_EXCL, 0600);
+		if (descriptor != -1)
+			shm_unlink(ss.str().c_str());
+#endif
+		if (descriptor == -1)
+			throw boost::system::system_error(errno, boost::system::system_category());
+
+		// reserve twice the size, then map the pages over both halves
+		void* address = MAP_FAILED;
+		if (ftruncate(descriptor, Size) == 0)
+			address = mmap(NULL, 2*Size, PROT_NONE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+		if (address != MAP_FAILED) {
+			storage = (uint8_t*)address;
+			if (mmap(storage, Size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, descriptor, 0) == MAP_FAILED ||
+				mmap(storage+Size, Size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_FIXED, descriptor, 0) == MAP_FAILED) {
+				munmap(address, 2*Size);
+				address = MAP_FAILED;
+			}
+		}
+		int error = errno;
+		close(descriptor);
+		if (address == MAP_FAILED)
+			throw boost::system::system_error(error, boost::system::system_category());
+	}
+
+	~SerialBasicReadBuffer() {
+		munmap(storage, 2*Size);
+	}
+
+	uint8_t* data() {
+		return storage;
+	}
+private:
+	uint8_t* storage;
+	SerialBasicReadBuffer(const SerialBasicReadBuffer&);
+	SerialBasicReadBuffer& operator=(const SerialBasicReadBuffer&);
+};
+#endif
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasic;
 typedef SerialBasic<> Serial;
 
+/**
+ * \brief A first-in first-out queue with a fixed capacity, for where SerialBasic must not allocate memory
+ */
+template <class Item, std::size_t Capacity>
+class SerialBasicFixedQueue {
+public:
+	SerialBasicFixedQueue() : begin(0), count(0) {}
+	bool empty() const {
+		return count == 0;
+	}
+	bool full() const {
+		return count == Capacity;
+	}
+	void push(const Item& item) {
+		items[(begin+count)%Capacity] = item;
+		count++;
+	}
+	Item& front() {
+		return items[begin];
+	}
+	Item pop() {
+		Item item = std::move(items[begin]);
+		begin = (begin+1)%Capacity;
+		count--;
+		return item;
+	}
+private:
+	Item items[Capacity];
+	std::size_t begin;
+	std::size_t count;
+};
+
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+/**
+ * \brief Memory for boost asio handlers, allocated from a memory resource
+ *
+ * Freed blocks are kept and reused, since boost allocates the same handlers for every asynchronous operation, and a 
+ * block is kept for each of the few operations that may be pending at once (e.g. a read and its timers). Thus, memory
+ * is taken from the memory resource only while the blocks grow, which suits memory resources that never
+ * reclaim memory.
+ *
+ * Handlers are allocated both on the io service thread and on the threads that start asynchronous operations (e.g.
+ * asyncWrite()), thus the blocks are locked.
+ */
+class SerialBasicHandlerMemory {
+public:
+	SerialBasicHandlerMemory(std::pmr::memory_resource* memoryResource) : memoryResource(memoryResource) {
+		for (std::size_t i = 0; i < BLOCK_COUNT; i++) {
+			blocks[i] = NULL;
+			blockSizes[i] = 0;
+			blocksInUse[i] = false;
+		}
+	}
+	~SerialBasicHandlerMemory() {
+		for (std::size_t i = 0; i < BLOCK_COUNT; i++)
+			if (blocks[i] != NULL)
+				memoryResource->deallocate(blocks[i], blockSizes[i]);
+	}
+	void* allocate(std::size_t size) {
+		boost::unique_lock<boost::mutex> scoped_lock(mutex);
+
+		// a free block that fits is preferred, otherwise the largest free block grows
+		std::size_t index = BLOCK_COUNT;
+		for (std::size_t i = 0; i < BLOCK_COUNT; i++) {
+			if (blocksInUse[i])
+				continue;
+			if (blockSizes[i] >= size) {
+				index = i;
+				break;
+			}
+			if (index == BLOCK_COUNT || blockSizes[i] > blockSizes[index])
+				index = i;
+		}
+		if (index == BLOCK_COUNT)
+			return memoryResource->allocate(size);
+		if (size > blockSizes[index]) {
+			if (blocks[index] != NULL)
+				memoryResource->deallocate(blocks[index], blockSizes[index]);
+			blocks[index] = memoryResource->allocate(size);
+			blockSizes[index] = size;
+		}
+		blocksInUse[index] = true;
+		return blocks[index];
+	}
+	void deallocate(void* pointer, std::size_t size) {
+		boost::unique_lock<boost::mutex> scoped_lock(mutex);
+		for (std::size_t i = 0; i < BLOCK_COUNT; i++) {
+			if (pointer == blocks[i]) {
+				blocksInUse[i] = false;
+				return;
+			}
+		}
+		memoryResource->deallocate(pointer, size);
+	}
+private:
+	const static std::size_t BLOCK_COUNT = 8;
+	boost::mutex mutex;
+	std::pmr::memory_resource* memoryResource;
+	void* blocks[BLOCK_COUNT];
+	std::size_t blockSizes[BLOCK_COUNT];
+	bool blocksInUse[BLOCK_COUNT];
+	SerialBasicHandlerMemory(const SerialBasicHandlerMemory&);
+	SerialBasicHandlerMemory& operator=(const SerialBasicHandlerMemory&);
+};
+
+/**
+ * \brief An allocator that takes memory from a SerialBasicHandlerMemory, associated with boost asio handlers
+ */
+template <class Value>
+class SerialBasicHandlerAllocator {
+public:
+	typedef Value value_type;
+	explicit SerialBasicHandlerAllocator(SerialBasicHandlerMemory* handlerMemory) : handlerMemory(handlerMemory) {}
+	template <class Other>
+	SerialBasicHandlerAllocator(const SerialBasicHandlerAllocator<Other>& other) : handlerMemory(other.handlerMemory) {}
+	Value* allocate(std::size_t count) {
+		return static_cast<Value*>(handlerMemory->allocate(count*sizeof(Value)));
+	}
+	void deallocate(Value* pointer, std::size_t count) {
+		handlerMemory->deallocate(pointer, count*sizeof(Value));
+	}
+	template <class Other>
+	bool operator==(const SerialBasicHandlerAllocator<Other>& other) const {
+		return handlerMemory == other.handlerMemory;
+	}
+	template <class Other>
+	bool operator!=(const SerialBasicHandlerAllocator<Other>& other) const {
+		return handlerMemory != other.handlerMemory;
+	}
+private:
+	template <class Other> friend class SerialBasicHandlerAllocator;
+	SerialBasicHandlerMemory* handlerMemory;
+};
+
+/**
+ * \brief Wraps a boost asio handler such that boost allocates the handler's memory from a SerialBasicHandlerMemory
+ *
+ * Boost 1.66 and later find the memory through the handler's associated allocator. Older versions, which predate 
+ * associated allocators, call the asio_handler_allocate() hooks instead, which were deprecated in boost 1.74.
+ */
+template <class Handler>
+class SerialBasicAllocatingHandler {
+public:
+	SerialBasicAllocatingHandler(Handler handler, SerialBasicHandlerMemory* handlerMemory) : 
+		handler(handler), handlerMemory(handlerMemory) {}
+	template <class... Arguments>
+	void operator()(Arguments&&... arguments) {
+		handler(std::forward<Arguments>(arguments)...);
+	}
+#if BOOST_VERSION >= 106600
+	typedef SerialBasicHandlerAllocator<void> allocator_type;
+	allocator_type get_allocator() const {
+		return allocator_type(handlerMemory);
+	}
+#else
+	friend void* asio_handler_allocate(std::size_t size, SerialBasicAllocatingHandler* context) {
+		return context->handlerMemory->allocate(size);
+	}
+	friend void asio_handler_deallocate(void* pointer, std::size_t size, SerialBasicAllocatingHandler* context) {
+		context->handlerMemory->deallocate(pointer, size);
+	}
+#endif
+private:
+	Handler handler;
+	SerialBasicHandlerMemory* handlerMemory;
+};
+#endif
+
 /**
  * \brief Writes and reads data to a serial port with 8N1, for a particular Type
  *
@@ -54,22 +355,88 @@ typedef SerialBasic<> Serial;
  * from the C++0x standard. SerialBasic is also intended for Windows operating systems, however the constructor method
  * can be modified for other operating systems supported by boost.
  *
+ * Reading and writing data does not allocate memory, since all buffers are sized at compile time by Config (see
+ * SerialBasicConfig). Memory is still allocated from the heap, though: the io service and its thread while the object
+ * is constructed, a node whenever a receive handler is added, the targets of the std::function handlers given to the
+ * object, and the asynchronous handlers, which boost allocates on the first operations and recycles afterwards. When
+ * compiled as C++17, the receive handlers and the asynchronous handlers are allocated from a std::pmr::memory_resource
+ * given to the constructor instead, and the buffers are placed in a memory resource by allocating the SerialBasic
+ * object itself from it. The io service and its thread are always allocated from the heap.
+ *
  * @see www.boost.org
  */
-template <class Type>
+template <class Type, class Config>
 class SerialBasic {
 public:
 	typedef uint8_t Byte;
 
+	/**
+	 * \brief Handler invoked with every chunk of bytes received from the serial port
+	 *
+	 * The handler is called from the io service thread while the SerialBasic object is locked, thus it may call read()
+	 * but it should return quickly, since the next asynchronous read is not issued until all handlers return.
+	 */
+	typedef std::function<void(const Byte*, std::size_t)> ReceiveHandler;
+
+	/**
+	 * \brief Handler invoked when the SerialBasic object notifies consumers (see setNotification())
+	 *
+	 * Called with the amount of complete items in the SerialBasic object's buffer, from the io service thread while the
+	 * SerialBasic object is locked.
+	 */
+	typedef std::function<void(std::size_t)> NotifyHandler;
+
+	/**
+	 * \brief Handler invoked once the data written to the serial port was transmitted (see asyncWaitTransmitted())
+	 */
+	typedef std::function<void()> TransmittedHandler;
+
+	/**
+	 * \brief Handler invoked once an asynchronous write completed (see asyncWrite())
+	 *
+	 * Called with the error of the write, if any, from the io service thread.
+	 */
+	typedef std::function<void(const boost::system::error_code&)> WriteHandler;
+
 	/**
 	 * \brief Attempt to open serial port with a given comPort and baudRate
 	 *
 	 * @param comPort The COM port
 	 * @param baudRate The baudrate
+	 * @param memoryResource (C++17 only) The memory resource from which the SerialBasic object allocates memory after
+	 * construction. It must outlive the SerialBasic object, and it must be thread-safe (e.g. a
+	 * synchronized_pool_resource, but not a monotonic_buffer_resource on its own), since it is used from the io
+	 * service thread and from the calling threads.
 	 * @throw boost::system::system_error Thrown if the attempt to open the serial port failed. Check boost error code
 	 * to find out the reason of the failure.
 	 */
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+	SerialBasic(uint16_t comPort, uint32_t baudRate, 
+		std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource());
+#else
 	SerialBasic(uint16_t comPort, uint32_t baudRate);
+#endif
+
+	/**
+	 * \brief Attempt to open serial port with a given device name and baudRate
+	 *
+	 * Intended for operating systems on which serial ports are not named COM1, COM2, etc. (e.g. /dev/ttyUSB0).
+	 *
+	 * @param portName The name of the serial port device
+	 * @param baudRate The baudrate
+	 * @param memoryResource (C++17 only) The memory resource from which the SerialBasic object allocates memory after
+	 * construction. It must outlive the SerialBasic object, and it must be thread-safe (e.g. a
+	 * synchronized_pool_resource, but not a monotonic_buffer_resource on its own), since it is used from the io
+	 * service thread and from the calling threads.
+	 * @throw boost::system::system_error Thrown if the attempt to open the serial port failed. Check boost error code
+	 * to find out the reason of the failure.
+	 */
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+	SerialBasic(const std::string& portName, uint32_t baudRate, 
+		std::pmr::memory_resource* memoryResource = std::pmr::get_default_resource());
+#else
+	SerialBasic(const std::string& portName, uint32_t baudRate);
+#endif
 
 	/**
 	 * \brief Destroy SerialBasic object
@@ -85,6 +452,44 @@ public:
 	 */
 	boost::system::error_code& getErrorCode();
 
+	/**
+	 * \brief Get the boost io service that runs the SerialBasic object's asynchronous operations
+	 *
+	 * Handlers posted to the io service, or to timers created from it, run on the same thread as the asynchronous reads.
+	 * They should return quickly, since reads are not handled while they run.
+	 *
+	 * @return The boost io service.
+	 */
+	boost::asio::io_service& getIoService();
+
+	/**
+	 * \brief Get the current baud rate of the serial port
+	 *
+	 * @return The baud rate.
+	 * @throw boost::system::system_error Thrown if the baud rate could not be read from the serial port.
+	 */
+	uint32_t getBaudRate();
+
+	/**
+	 * \brief Change the baud rate of the serial port
+	 *
+	 * Data that is being transmitted or received while the baud rate changes is corrupted, thus the baud rate should
+	 * only be changed while the link is idle, e.g. as agreed with the other end by SerialBasicBaudRateNegotiation.
+	 *
+	 * @param baudRate The baud rate.
+	 * @throw boost::system::system_error Thrown if the baud rate could not be set on the serial port.
+	 */
+	void setBaudRate(uint32_t baudRate);
+
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+	/**
+	 * \brief Get the memory resource from which the SerialBasic object allocates memory
+	 *
+	 * @return The memory resource given to the constructor.
+	 */
+	std::pmr::memory_resource* getMemoryResource();
+#endif
+
 	/**
 	 * \brief Read serial data from the SerialBasic object's buffer (non-blocking)
 	 *
@@ -99,6 +504,129 @@ public:
 	template <class BeginIterator>
 	std::size_t read(BeginIterator beginIterator, std::size_t size);
 
+	/**
+	 * \brief Get the amount of complete items in the SerialBasic object's buffer (non-blocking)
+	 *
+	 * @return The amount of items that read() can currently save.
+	 */
+	std::size_t available();
+
+	/**
+	 * \brief Access the data in the SerialBasic object's buffer in place (non-blocking)
+	 *
+	 * The data remains valid and in the buffer until it is consumed with consume(). If the read buffer is mirrored
+	 * (see SerialBasicConfig), all of the buffered data is contiguous. Otherwise, only the data up to the point at which
+	 * the buffer wraps is accessed, and the rest is accessed by calling peek() again after consume().
+	 *
+	 * @param data Set to the first buffered byte.
+	 * @return The amount of contiguous bytes at data.
+	 */
+	std::size_t peek(const Byte*& data);
+
+	/**
+	 * \brief Remove data accessed with peek() from the SerialBasic object's buffer
+	 *
+	 * @param size The amount of bytes to remove. Should be a multiple of sizeof(Type), so that read() stays aligned
+	 * with the items.
+	 */
+	void consume(std::size_t size);
+
+	/**
+	 * \brief Lend a buffer into which data is received directly
+	 *
+	 * Once a buffer is lent, the SerialBasic object receives data into lent buffers instead of its own buffer, thus the
+	 * data is never copied. Each filled buffer is queued until it is taken back with reclaim(), and it can then be lent
+	 * again. While no lent buffer is free, the SerialBasic object stops receiving, and the data waits in the operating 
+	 * system's buffer. Receive handlers are still called with each filled buffer.
+	 *
+	 * A read that is already pending when the first buffer is lent still completes into the SerialBasic object's
+	 * buffer, thus the data it receives is read with read() or peek() rather than reclaimed.
+	 *
+	 * @param buffer The buffer. It must remain valid until it is reclaimed, or until the SerialBasic object is destroyed.
+	 * @param capacity The capacity of the buffer in bytes.
+	 * @throw boost::system::system_error Thrown if MAX_LENT_BUFFERS buffers are already lent.
+	 */
+	void lend(Byte* buffer, std::size_t capacity);
+
+	/**
+	 * \brief Take back a filled buffer (non-blocking)
+	 *
+	 * Filled buffers are taken back in the order they were filled. A filled buffer holds the data of a single 
+	 * asynchronous read, which need not consist of whole items. Once every buffer is taken back, data is received into
+	 * the SerialBasic object's buffer again.
+	 *
+	 * @param buffer Set to the filled buffer.
+	 * @param size Set to the amount of bytes received into the buffer. 0 if receiving failed (see getErrorCode()).
+	 * @return False if no filled buffer is queued, in which case buffer and size are unchanged.
+	 */
+	bool reclaim(Byte*& buffer, std::size_t& size);
+
+	/**
+	 * \brief The content of a read buffer handed off by drain()
+	 *
+	 * The backlog is split in two parts if it wraps around the end of the read buffer, in which case an item may
+	 * straddle both parts, unless the read buffer is decoded (see SerialBasicConfig). The parts of a mirrored read
+	 * buffer never wrap.
+	 */
+	struct Backlog {
+		const Byte* data;			/**< The first part of the backlog */
+		std::size_t size;			/**< The size of the first part in bytes */
+		const Byte* wrappedData;	/**< The second part of the backlog, at the start of the read buffer */
+		std::size_t wrappedSize;	/**< The size of the second part in bytes, which is 0 if the backlog did not wrap */
+	};
+
+	/**
+	 * \brief Hand off every complete item in the SerialBasic object's buffer at once, without copying (non-blocking)
+	 *
+	 * The filled read buffer is swapped with the second read buffer of a drainable configuration (see 
+	 * SerialBasicConfig), into which data is received from then on, thus the cost does not depend on the size of the
+	 * backlog. Only a partial item at the end of the backlog is copied, so that it is completed in the second buffer.
+	 *
+	 * @param backlog Set to the handed off items, which remain valid until release() is called.
+	 * @return False if the read buffer is not drainable, if the previous backlog was not released, if no complete item
+	 * is buffered, or if a read into the previously drained buffer is still pending, in which case backlog is
+	 * unchanged.
+	 */
+	bool drain(Backlog& backlog);
+
+	/**
+	 * \brief Give back the read buffer handed off by drain(), so that it can be drained into again
+	 */
+	void release();
+
+	/**
+	 * \brief Receive slowly arriving data in fewer, larger reads
+	 *
+	 * The amount of bytes requested by each asynchronous read adapts to the arrival pattern regardless of this setting:
+	 * it doubles whenever a read fills it, up to the size of the transfer buffer (or of the read buffer, if mirrored),
+	 * and it halves whenever a read returns less than a quarter of it. In addition, if a read returns fewer than 
+	 * minimumBytes, the next read is delayed by the time minimumBytes take to arrive at the observed arrival rate, but 
+	 * never by more than maximumLatency. Meanwhile the data waits in the operating system's buffer, thus it is received
+	 * with fewer completions, each of which wakes the io service thread and calls the receive handlers.
+	 *
+	 * @param minimumBytes The amount of bytes below which the next read is delayed. 0 never delays reads, which is the
+	 * default.
+	 * @param maximumLatency The maximum delay in microseconds, which bounds the latency added to received data. It
+	 * should be short enough that the operating system's buffer does not overflow meanwhile.
+	 */
+	void setReadBatching(std::size_t minimumBytes, uint32_t maximumLatency);
+
+	/**
+	 * \brief Get the inline size of a SerialBasic object
+	 *
+	 * This is sizeof(SerialBasic), which includes every read, transfer and write buffer, since they are sized at compile
+	 * time. It is not the object's total memory use, since it excludes the memory the object's members allocate
+	 * themselves, which remains allocated from the heap (or from the memory resource, C++17 only): the io service and
+	 * its thread, allocated during construction, and the pages of a mirrored read buffer, as well as the nodes of the
+	 * receive handler registry, the targets of std::function handlers and the asynchronous handlers, allocated after
+	 * construction.
+	 *
+	 * @return The size of the SerialBasic object in bytes.
+	 */
+	static constexpr std::size_t inlineSize() {
+		return sizeof(SerialBasic);
+	}
+
 	/**
 	 * \brief Write serial data to the serial port (blocking)
 	 *
@@ -108,53 +636,458 @@ public:
 	 * array of characters, size is the maximum amount of characters written to the serial port associated with the SerialBasic
 	 * object. It is up to the developer to ensure the buffer to which beginIterator refers is at least as large as the 
 	 * specified size.
+	 * Concurrent calls are serialized, so the data written by one call is never interleaved with the data of another.
 	 * @throw boost::system::system_error Thrown if there is a failure to write data to the serial port. Check boost error code
 	 * to find out the reason of the failure.
 	 */
 	template <class BeginIterator>
 	void write(BeginIterator beginIterator, std::size_t size);
+
+	/**
+	 * \brief Write serial data to the serial port (non-blocking)
+	 *
+	 * Asynchronous writes are queued and written in order by the io service thread, which never blocks on them, thus 
+	 * this is how data should be written from the io service thread (e.g. from timers). A write() waits for the queued
+	 * asynchronous writes, and the data of a write() is never interleaved with the data of an asynchronous write.
+	 *
+	 * @param items The items to write, which must remain valid until the handler is called.
+	 * @param size The amount of items.
+	 * @param writeHandler The handler, which is called from the io service thread once the items are written, or an empty
+	 * handler. Handlers of writes that are still queued when the SerialBasic object is destroyed are not called.
+	 * @throw boost::system::system_error Thrown if MAX_ASYNCHRONOUS_WRITES writes are already queued.
+	 */
+	void asyncWrite(const Type* items, std::size_t size, WriteHandler writeHandler);
+
+	/**
+	 * \brief Register a handler that observes every chunk of received bytes
+	 *
+	 * Received bytes are still saved to the SerialBasic object's buffer, so read() is unaffected. Each chunk is passed 
+	 * to the handler in full, even if the SerialBasic object's buffer could not save all of it.
+	 *
+	 * The registry of handlers is allocated from the SerialBasic object's memory resource, however std::function
+	 * allocates a handler's target itself if the target is too large to be stored inline (e.g. a lambda function that
+	 * captures more than a few pointers).
+	 *
+	 * @param receiveHandler The handler. It must not add or remove receive handlers itself.
+	 * @return An identifier that can be passed to removeReceiveHandler.
+	 */
+	std::size_t addReceiveHandler(ReceiveHandler receiveHandler);
+
+	/**
+	 * \brief Unregister a handler previously registered with addReceiveHandler
+	 *
+	 * Once this method returns, the handler is no longer invoked.
+	 *
+	 * @param handlerId The identifier returned by addReceiveHandler.
+	 */
+	void removeReceiveHandler(std::size_t handlerId);
+
+	/**
+	 * \brief Set when consumers are notified of received items
+	 *
+	 * Similar to VMIN and VTIME of a terminal, consumers are only notified once minimumItems complete items are in the
+	 * SerialBasic object's buffer, or once maximumDelay microseconds passed since an item was received without a 
+	 * notification, whichever comes first. A notification wakes the threads blocked in wait() and calls the notify 
+	 * handler. By default, consumers are notified whenever a read completes with at least one complete item buffered.
+	 *
+	 * Receive handlers are unaffected, thus they are still called with every chunk.
+	 *
+	 * @param minimumItems The amount of items that causes an immediate notification.
+	 * @param maximumDelay The maximum time in microseconds a received item waits for a notification.
+	 * @param notifyHandler The handler called with each notification, if any.
+	 */
+	void setNotification(std::size_t minimumItems, uint32_t maximumDelay, NotifyHandler notifyHandler = NotifyHandler());
+
+	/**
+	 * \brief Wait for a notification (blocking)
+	 *
+	 * Returns immediately if minimumItems complete items are already in the SerialBasic object's buffer.
+	 *
+	 * @param timeout The maximum time to wait in milliseconds.
+	 * @return The amount of complete items in the SerialBasic object's buffer, which can be 0 if the timeout expired.
+	 */
+	std::size_t wait(uint32_t timeout);
+
+	/**
+	 * \brief Wait for items to arrive (blocking)
+	 *
+	 * Unlike wait(timeout), this does not return while only items that the caller already inspected are buffered (e.g.
+	 * the beginning of a message that is not complete yet), thus a consumer that waits for the rest of its data does 
+	 * not spin.
+	 *
+	 * @param timeout The maximum time to wait in milliseconds.
+	 * @param items The amount of items the caller already inspected, typically the result of available().
+	 * @return The amount of complete items in the SerialBasic object's buffer, which is greater than items unless the
+	 * timeout expired.
+	 */
+	std::size_t wait(uint32_t timeout, std::size_t items);
+
+	/**
+	 * \brief Discard partial items that stall, so an unframed stream realigns with the items
+	 *
+	 * Items are not framed, thus if a transmission is truncated, the rest of a partial item is taken from the next item
+	 * and every later item is misaligned. Once resynchronization is enabled, a partial item that receives no further
+	 * data for a gap of gapCharacters character times at the port's baud rate is discarded and counted. The gap should 
+	 * be longer than any pause expected within the transmission of an item.
+	 *
+	 * @param gapCharacters The gap in character times, each of which is 10 bits (8N1). 0 disables resynchronization,
+	 * which is the default.
+	 */
+	void setResynchronization(uint32_t gapCharacters);
+
+	/**
+	 * \brief Get the amount of partial items discarded by resynchronization
+	 *
+	 * @return The amount of discarded partial items.
+	 */
+	uint64_t getDiscardedItems();
+
+	/**
+	 * \brief Get the amount of bytes written to the serial port but not transmitted yet
+	 *
+	 * write() returns once the data is in the operating system's output queue, which may hold seconds of data at a low
+	 * baud rate. This is the amount of bytes still in that queue (TIOCOUTQ, or the output queue reported by
+	 * ClearCommError() on Windows). Depending on the driver, bytes in the UART's FIFO may not be counted.
+	 *
+	 * @return The amount of bytes in the output queue.
+	 * @throw boost::system::system_error Thrown if the output queue could not be queried.
+	 */
+	std::size_t getOutputQueueSize();
+
+	/**
+	 * \brief Estimate the time the output queue takes to be transmitted
+	 *
+	 * @return The time in microseconds at the port's baud rate, at 10 bits per byte.
+	 * @throw boost::system::system_error Thrown if the output queue could not be queried.
+	 */
+	uint32_t getOutputQueueTime();
+
+	/**
+	 * \brief Wait until all data written so far was transmitted (blocking)
+	 *
+	 * Unlike write(), which returns once the data is queued, this returns once the data left the serial port (tcdrain(),
+	 * or FlushFileBuffers() on Windows), e.g. to measure the latency of a transmission or before changing the baud rate.
+	 *
+	 * @throw boost::system::system_error Thrown if waiting for the transmission failed.
+	 */
+	void waitTransmitted();
+
+	/**
+	 * \brief Call a handler once all data written so far was transmitted (non-blocking)
+	 *
+	 * The output queue is checked on the io service thread whenever it should have been transmitted at the port's baud
+	 * rate, thus the handler is called about when the last byte left the serial port, without blocking a thread. If the
+	 * output queue cannot be queried, the handler is called once the time estimated when asyncWaitTransmitted() was
+	 * called passed.
+	 *
+	 * @param transmittedHandler The handler, which is called from the io service thread.
+	 * @throw boost::system::system_error Thrown if MAX_TRANSMITTED_HANDLERS handlers are already waiting.
+	 */
+	void asyncWaitTransmitted(TransmittedHandler transmittedHandler);
+
+	/**
+	 * \brief Keep the output queue shallow by pacing writes
+	 *
+	 * Once set, write() waits before writing while the output queue takes longer than maximumTime to be transmitted,
+	 * and an asynchronous write is delayed by a timer instead (see asyncWrite()). Thus the data waits in the 
+	 * application, where it can still be prioritized or dropped (e.g. by SerialBasicSpillQueue), rather than in the
+	 * operating system, and the latency of each write stays bounded.
+	 *
+	 * @param maximumTime The maximum time in microseconds the output queue takes to be transmitted before a write. 0
+	 * disables pacing, which is the default.
+	 */
+	void setOutputQueueLimit(uint32_t maximumTime);
+
+	/**
+	 * \brief Get the amount of bytes waiting in the operating system's input queue
+	 *
+	 * The input queue (FIONREAD, or the input queue reported by ClearCommError() on Windows) is sampled on the io service
+	 * thread before each read that may find a backlog, i.e. after a read that filled its request or was delayed, and the
+	 * read requests the whole backlog at once, as far as the free space of the read buffer allows. A lasting backlog
+	 * means the io service thread receives data slower than it arrives (e.g. because receive handlers are slow, reads 
+	 * are delayed by batching or all lent buffers are held), whereas a SerialBasic object's buffer that fills up means
+	 * its consumers are slower.
+	 *
+	 * @return The amount of bytes in the input queue when it was last sampled.
+	 */
+	std::size_t getInputQueueSize();
+
+	/**
+	 * \brief Get the largest amount of bytes sampled in the operating system's input queue
+	 *
+	 * @return The largest amount of bytes in the input queue since the previous call.
+	 */
+	std::size_t getInputQueuePeak();
 private:
 	boost::recursive_mutex recursiveMutex;
+	boost::mutex writeMutex;
 	boost::system::error_code errorCode;
-	const static std::size_t READ_BUFFER_SIZE = 512;
-	const static std::size_t READ_TRANSFER_BUFFER_SIZE = 128;
+	const static bool DECODED_READ_BUFFER = Config::DECODED_READ_BUFFER;
+	const static std::size_t READ_BUFFER_COUNT = Config::DRAINABLE_READ_BUFFER ? 2 : 1;
+	const static std::size_t READ_BUFFER_SIZE = DECODED_READ_BUFFER ? 
+		Config::READ_BUFFER_SIZE-Config::READ_BUFFER_SIZE%sizeof(Type) : 
+		Config::READ_BUFFER_SIZE;
+	const static std::size_t READ_TRANSFER_BUFFER_SIZE = Config::READ_TRANSFER_BUFFER_SIZE;
+	const static std::size_t WRITE_BUFFER_SIZE = Config::WRITE_BUFFER_SIZE;
+	const static bool MIRRORED_READ_BUFFER = Config::MIRRORED_READ_BUFFER;
+	const static std::size_t MAX_LENT_BUFFERS = 16;
+	const static std::size_t MAX_TRANSMITTED_HANDLERS = 16;
+	const static std::size_t MAX_ASYNCHRONOUS_WRITES = 16;
+	const static std::size_t MAX_READ_SIZE = MIRRORED_READ_BUFFER ? READ_BUFFER_SIZE : READ_TRANSFER_BUFFER_SIZE;
+	const static std::size_t MIN_READ_SIZE = (MAX_READ_SIZE < 16) ? MAX_READ_SIZE : 16;
+	typedef std::chrono::steady_clock Clock;
+	static_assert(READ_BUFFER_SIZE >= sizeof(Type), "The read buffer must fit at least one item");
+	static_assert(WRITE_BUFFER_SIZE >= sizeof(Type), "The write buffer must fit at least one item");
+	static_assert(!(MIRRORED_READ_BUFFER && DECODED_READ_BUFFER), "A mirrored read buffer cannot be decoded");
+#if defined(SERIAL_BASIC_HAS_MIRRORED_READ_BUFFER)
+	const static bool MIRRORED_READ_BUFFER_SUPPORTED = true;
+#else
+	const static bool MIRRORED_READ_BUFFER_SUPPORTED = false;
+#endif
+	static_assert(!MIRRORED_READ_BUFFER || MIRRORED_READ_BUFFER_SUPPORTED, 
+		"A mirrored read buffer is not supported on this operating system");
 	Byte readTransferBuffer[READ_TRANSFER_BUFFER_SIZE];
-	std::list<Byte> readBuffer;
+	SerialBasicReadBuffer<READ_BUFFER_SIZE, MIRRORED_READ_BUFFER, alignof(Type)> readBuffers[READ_BUFFER_COUNT];
+	std::size_t readBufferIndex;
+	bool readBufferDrained;
+	bool directReadPending;
+	std::size_t directReadIndex;
+	std::size_t readBufferBegin;
+	std::size_t readBufferSize;
+	Byte partialItem[sizeof(Type)];
+	std::size_t partialItemSize;
+	struct LentBuffer {
+		Byte* data;
+		std::size_t capacity;
+		std::size_t size;
+	};
+	SerialBasicFixedQueue<LentBuffer, MAX_LENT_BUFFERS> freeLentBuffers;
+	SerialBasicFixedQueue<LentBuffer, MAX_LENT_BUFFERS> filledLentBuffers;
+	std::size_t lentBufferCount;
+	bool readPaused;
+	std::size_t readSize;
+	std::size_t readBatchingMinimumBytes;
+	uint32_t readBatchingMaximumLatency;
+	double arrivalRate;
+	Clock::time_point lastReadTime;
+	std::size_t notifyMinimumItems;
+	uint32_t notifyMaximumDelay;
+	NotifyHandler notifyHandler;
+	bool notifyTimerArmed;
+	boost::mutex notifyMutex;
+	boost::condition_variable notifyCondition;
+	uint64_t notifySequence;
+	double characterTime;
+	uint32_t resynchronizationGap;
+	uint64_t resynchronizationSequence;
+	uint64_t discardedItems;
+	uint32_t outputQueueLimit;
+	struct AsynchronousWrite {
+		const Type* items;
+		std::size_t size;
+		WriteHandler writeHandler;
+	};
+	SerialBasicFixedQueue<AsynchronousWrite, MAX_ASYNCHRONOUS_WRITES> asynchronousWrites;
+	bool writing;
+	boost::condition_variable writeCondition;
+	SerialBasicFixedQueue<TransmittedHandler, MAX_TRANSMITTED_HANDLERS> transmittedHandlers;
+	bool inputQueueBacklog;
+	std::size_t inputQueueSize;
+	std::size_t inputQueuePeak;
+	Type writeBuffer[WRITE_BUFFER_SIZE/sizeof(Type)];
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+	std::pmr::memory_resource* memoryResource;
+	SerialBasicHandlerMemory handlerMemory;
+	std::pmr::map<std::size_t, ReceiveHandler> receiveHandlers;
+#else
+	std::map<std::size_t, ReceiveHandler> receiveHandlers;
+#endif
+	std::size_t nextReceiveHandlerId;
 	boost::asio::io_service io;
 	boost::asio::io_service::work work_;
 	boost::asio::strand strand_;
 	boost::asio::serial_port serial;
+	boost::asio::steady_timer readTimer;
+	boost::asio::steady_timer notifyTimer;
+	boost::asio::steady_timer resynchronizationTimer;
+	boost::asio::steady_timer transmitTimer;
+	boost::asio::steady_timer writeTimer;
 	boost::thread thread_;
+	static std::string comPortName(uint16_t comPort);
+	void open(const std::string& portName, uint32_t baudRate);
+	void copyToReadBuffer(const Byte* source, std::size_t size);
+	void decodeToReadBuffer(const Byte* source, std::size_t size);
+	void copyFromReadBuffer(Byte* destination, std::size_t size);
+	template <class BeginIterator>
+	void readItems(BeginIterator beginIterator, std::size_t size, std::true_type);
+	template <class BeginIterator>
+	void readItems(BeginIterator beginIterator, std::size_t size, std::false_type);
+	template <class BeginIterator>
+	void writeItems(BeginIterator beginIterator, std::size_t size, std::true_type);
+	template <class BeginIterator>
+	void writeItems(BeginIterator beginIterator, std::size_t size, std::false_type);
+	void scheduleAsynchronousRead(std::size_t requestedSize, std::size_t size);
+	void updateNotification();
+	void updateResynchronization();
+	void notify();
+	std::size_t queryQueueSize(bool input, boost::system::error_code& error);
+	void scheduleTransmitCheck();
+	void paceWrite();
+	void finishWrite();
+	void setAsynchronousWrite();
+	template <class Handler>
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+	SerialBasicAllocatingHandler<Handler> allocate(Handler handler) {
+		return SerialBasicAllocatingHandler<Handler>(handler, &handlerMemory);
+	}
+#else
+	Handler allocate(Handler handler) {
+		return handler;
+	}
+#endif
+
+	// the handler runs in the strand, and both the asynchronous operation and the strand's dispatch of the handler
+	// allocate from the handler memory, since boost does not look through the strand's wrapper for an allocator
+	template <class Handler>
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+	auto wrap(Handler handler) -> SerialBasicAllocatingHandler<decltype(strand_.wrap(allocate(handler)))> {
+		return allocate(strand_.wrap(allocate(handler)));
+	}
+#else
+	auto wrap(Handler handler) -> decltype(strand_.wrap(handler)) {
+		return strand_.wrap(handler);
+	}
+#endif
 	void setAsynchronousRead() {
+		boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+
+		// a read that returned less than it requested left the input queue empty, thus the input queue is only sampled
+		// when it may hold a backlog, which is then requested at once
+		std::size_t requestSize = readSize;
+		inputQueueSize = 0;
+		if (inputQueueBacklog) {
+			boost::system::error_code error;
+			inputQueueSize = queryQueueSize(true, error);
+			inputQueuePeak = (inputQueueSize > inputQueuePeak) ? inputQueueSize : inputQueuePeak;
+			requestSize = (inputQueueSize > readSize) ? inputQueueSize : readSize;
+		}
+
+		// data is received directly into a lent buffer, or into the free space of a mirrored read buffer since it is
+		// contiguous, unless it is full. A backlog larger than the transfer buffer is received directly into the free
+		// space of a read buffer that is not mirrored as well, as long as enough of it is contiguous.
+		LentBuffer lentBuffer = {NULL, 0, 0};
+		Byte* destination = readTransferBuffer;
+		std::size_t capacity = (requestSize < READ_TRANSFER_BUFFER_SIZE) ? requestSize : READ_TRANSFER_BUFFER_SIZE;
+		if (lentBufferCount != 0) {
+			if (freeLentBuffers.empty()) {
+				inputQueueBacklog = true;
+				readPaused = true;
+				return;
+			}
+			lentBuffer = freeLentBuffers.pop();
+			destination = lentBuffer.data;
+			capacity = lentBuffer.capacity;
+		} else if (readBufferSize != READ_BUFFER_SIZE && DECODED_READ_BUFFER == false) {
+			std::size_t end = (readBufferBegin+readBufferSize)%READ_BUFFER_SIZE;
+			std::size_t freeSize = READ_BUFFER_SIZE-readBufferSize;
+			if (MIRRORED_READ_BUFFER == false && READ_BUFFER_SIZE-end < freeSize)
+				freeSize = READ_BUFFER_SIZE-end;
+			if (MIRRORED_READ_BUFFER || (requestSize > READ_TRANSFER_BUFFER_SIZE && freeSize > READ_TRANSFER_BUFFER_SIZE)) {
+				destination = readBuffers[readBufferIndex].data()+end;
+				capacity = (freeSize < requestSize) ? freeSize : requestSize;
+				directReadPending = true;
+				directReadIndex = readBufferIndex;
+			}
+		}
 		serial.async_read_some(
-				boost::asio::buffer(readTransferBuffer, READ_TRANSFER_BUFFER_SIZE),
-				strand_.wrap([&](const boost::system::error_code& error, std::size_t size)->void{
+				boost::asio::buffer(destination, capacity),
+				wrap([this, lentBuffer, destination, capacity](const boost::system::error_code& error, 
+					std::size_t size)->void{
 			boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+			directReadPending = false;
+			if (lentBuffer.data != NULL) {
+				LentBuffer filledBuffer = lentBuffer;
+				filledBuffer.size = error ? 0 : size;
+				filledLentBuffers.push(filledBuffer);
+			}
 			if (error == false) {
-				std::size_t bytesSum = readBuffer.size()+size;
-				std::size_t bytesRemaining =  (bytesSum < READ_BUFFER_SIZE) ? READ_BUFFER_SIZE-bytesSum : 0;
-				std::size_t bytesToTransfer = (bytesRemaining < size) ? bytesRemaining : size;
-				std::copy(readTransferBuffer, readTransferBuffer+bytesToTransfer, std::back_inserter(readBuffer));
-				setAsynchronousRead();
+				if (destination == readTransferBuffer && DECODED_READ_BUFFER) {
+					decodeToReadBuffer(readTransferBuffer, size);
+				} else if (destination == readTransferBuffer) {
+					copyToReadBuffer(readTransferBuffer, size);
+				} else if (lentBuffer.data == NULL && destination != readBuffers[readBufferIndex].data()+
+					(readBufferBegin+readBufferSize)%READ_BUFFER_SIZE) {
+
+					// the read buffer was drained, or a partial item was discarded from its end, while data was 
+					// received directly into it
+					copyToReadBuffer(destination, size);
+				} else if (lentBuffer.data == NULL) {
+					readBufferSize += size;
+				}
+				for (auto handler = receiveHandlers.begin(); handler != receiveHandlers.end(); handler++)
+					handler->second(destination, size);
+				if (lentBuffer.data == NULL) {
+					updateNotification();
+					updateResynchronization();
+				}
+				scheduleAsynchronousRead(capacity, size);
 			}
 			errorCode = error;
 		}));
 	}
 };
 
-template <class Type>
-SerialBasic<Type>::SerialBasic(uint16_t comPort, uint32_t baudRate) : work_(io), strand_(io), serial(io) {
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+template <class Type, class Config>
+SerialBasic<Type, Config>::SerialBasic(uint16_t comPort, uint32_t baudRate, std::pmr::memory_resource* memoryResource) : 
+	SerialBasic(comPortName(comPort), baudRate, memoryResource) {}
+#else
+template <class Type, class Config>
+SerialBasic<Type, Config>::SerialBasic(uint16_t comPort, uint32_t baudRate) : 
+	SerialBasic(comPortName(comPort), baudRate) {}
+#endif
 
-		// attempt to open com port
-		std::stringstream ss;
-		ss << "COM" << comPort;
-		serial.open(ss.str());
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+template <class Type, class Config>
+SerialBasic<Type, Config>::SerialBasic(const std::string& portName, uint32_t baudRate, 
+	std::pmr::memory_resource* memoryResource) : 
+#else
+template <class Type, class Config>
+SerialBasic<Type, Config>::SerialBasic(const std::string& portName, uint32_t baudRate) : 
+#endif
+	readBufferIndex(0), readBufferDrained(false), directReadPending(false), directReadIndex(0), readBufferBegin(0),
+	readBufferSize(0), partialItemSize(0), lentBufferCount(0), readPaused(false), readSize(MAX_READ_SIZE),
+	readBatchingMinimumBytes(0), readBatchingMaximumLatency(0), arrivalRate(0.0), notifyMinimumItems(1),
+	notifyMaximumDelay(0), notifyTimerArmed(false), notifySequence(0), characterTime(0.0), resynchronizationGap(0),
+	resynchronizationSequence(0), discardedItems(0), outputQueueLimit(0), writing(false), inputQueueBacklog(true),
+	inputQueueSize(0), inputQueuePeak(0), 
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+	memoryResource(memoryResource), handlerMemory(memoryResource), receiveHandlers(memoryResource),
+#endif
+	nextReceiveHandlerId(0), work_(io), strand_(io), serial(io), readTimer(io), notifyTimer(io),
+	resynchronizationTimer(io), transmitTimer(io), writeTimer(io) {
+		open(portName, baudRate);
+}
+
+template <class Type, class Config>
+std::string SerialBasic<Type, Config>::comPortName(uint16_t comPort) {
+	std::stringstream ss;
+	ss << "COM" << comPort;
+	return ss.str();
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::open(const std::string& portName, uint32_t baudRate) {
+
+		// attempt to open port
+		serial.open(portName);
 
 		// set options
 		serial.set_option(boost::asio::serial_port_base::parity());	
 		serial.set_option(boost::asio::serial_port_base::character_size(8));
 		serial.set_option(boost::asio::serial_port_base::stop_bits());	
 		serial.set_option(boost::asio::serial_port_base::baud_rate(baudRate));
+		characterTime = 10.0*1000000.0/baudRate;
 
 		// set up thread for io service
 		thread_ = boost::thread([&]()->void{
@@ -167,51 +1100,682 @@ SerialBasic<Type>::SerialBasic(uint16_t comPort, uint32_t baudRate) : work_(io),
 		});
 
 		// set asynchronous read
+		lastReadTime = Clock::now();
 		setAsynchronousRead();
 }
 
-template <class Type>
-SerialBasic<Type>::~SerialBasic() {
+template <class Type, class Config>
+SerialBasic<Type, Config>::~SerialBasic() {
 	io.stop();
 	serial.close();
 	thread_.join();
 }
 
-template <class Type>
-boost::system::error_code& SerialBasic<Type>::getErrorCode() {
+template <class Type, class Config>
+boost::system::error_code& SerialBasic<Type, Config>::getErrorCode() {
 	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
 	return errorCode;
 }
 
-template <class Type>
+template <class Type, class Config>
+boost::asio::io_service& SerialBasic<Type, Config>::getIoService() {
+	return io;
+}
+
+template <class Type, class Config>
+uint32_t SerialBasic<Type, Config>::getBaudRate() {
+	boost::asio::serial_port_base::baud_rate baudRate;
+	serial.get_option(baudRate);
+	return baudRate.value();
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::setBaudRate(uint32_t baudRate) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	serial.set_option(boost::asio::serial_port_base::baud_rate(baudRate));
+	characterTime = 10.0*1000000.0/baudRate;
+}
+
+#if defined(SERIAL_BASIC_HAS_MEMORY_RESOURCE)
+template <class Type, class Config>
+std::pmr::memory_resource* SerialBasic<Type, Config>::getMemoryResource() {
+	return memoryResource;
+}
+#endif
+
+template <class Type, class Config>
 template <class BeginIterator>
-std::size_t SerialBasic<Type>::read(BeginIterator beginIterator, std::size_t size) {
+std::size_t SerialBasic<Type, Config>::read(BeginIterator beginIterator, std::size_t size) {
 	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
-	std::size_t numberOfCompletedItems = readBuffer.size()/sizeof(Type);
+	std::size_t numberOfCompletedItems = readBufferSize/sizeof(Type);
 	std::size_t itemsToTransfer = (numberOfCompletedItems < size) ? 
 		numberOfCompletedItems : 
 		size;
 	if (itemsToTransfer == 0)
 		return 0;
-	std::size_t bytesToTransfer = itemsToTransfer*sizeof(Type); 
-	std::unique_ptr<Byte[]> buffer(new Byte[bytesToTransfer]);
-	std::list<Byte>::iterator end = readBuffer.begin();
-	std::advance(end, bytesToTransfer);
-	std::copy(readBuffer.begin(), end, buffer.get());
-	readBuffer.erase(readBuffer.begin(), end);
-	std::copy((Type*)buffer.get(), 
-		((Type*)buffer.get())+itemsToTransfer, 
-		beginIterator);
+	readItems(beginIterator, itemsToTransfer, std::is_convertible<BeginIterator, Type*>());
 	return itemsToTransfer;
 }
 
-template <class Type>
+template <class Type, class Config>
+std::size_t SerialBasic<Type, Config>::available() {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	return readBufferSize/sizeof(Type);
+}
+
+template <class Type, class Config>
+std::size_t SerialBasic<Type, Config>::peek(const Byte*& data) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	data = readBuffers[readBufferIndex].data()+readBufferBegin;
+	if (MIRRORED_READ_BUFFER || readBufferBegin+readBufferSize <= READ_BUFFER_SIZE)
+		return readBufferSize;
+	return READ_BUFFER_SIZE-readBufferBegin;
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::consume(std::size_t size) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	if (size > readBufferSize)
+		size = readBufferSize;
+	readBufferBegin = (readBufferBegin+size)%READ_BUFFER_SIZE;
+	readBufferSize -= size;
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::lend(Byte* buffer, std::size_t capacity) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	if (lentBufferCount == MAX_LENT_BUFFERS)
+		throw boost::system::system_error(boost::system::errc::make_error_code(
+			boost::system::errc::no_buffer_space));
+	LentBuffer lentBuffer = {buffer, capacity, 0};
+	freeLentBuffers.push(lentBuffer);
+	lentBufferCount++;
+	if (readPaused) {
+		readPaused = false;
+		setAsynchronousRead();
+	}
+}
+
+template <class Type, class Config>
+bool SerialBasic<Type, Config>::reclaim(Byte*& buffer, std::size_t& size) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	if (filledLentBuffers.empty())
+		return false;
+	LentBuffer filledBuffer = filledLentBuffers.pop();
+	lentBufferCount--;
+	buffer = filledBuffer.data;
+	size = filledBuffer.size;
+
+	// once the last buffer is taken back, data is received into the SerialBasic object's buffer again
+	if (readPaused) {
+		readPaused = false;
+		setAsynchronousRead();
+	}
+	return true;
+}
+
+template <class Type, class Config>
+bool SerialBasic<Type, Config>::drain(Backlog& backlog) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	if (READ_BUFFER_COUNT == 1 || readBufferDrained || readBufferSize < sizeof(Type))
+		return false;
+
+	// the fresh buffer is not swapped in while data is still being received into it, which is only the case until
+	// the first read after the previous drain completes
+	if (directReadPending && directReadIndex != readBufferIndex)
+		return false;
+	Byte* data = readBuffers[readBufferIndex].data();
+	std::size_t wholeSize = readBufferSize-readBufferSize%sizeof(Type);
+	backlog.data = data+readBufferBegin;
+	backlog.wrappedData = data;
+	if (MIRRORED_READ_BUFFER || readBufferBegin+wholeSize <= READ_BUFFER_SIZE) {
+		backlog.size = wholeSize;
+		backlog.wrappedSize = 0;
+	} else {
+		backlog.size = READ_BUFFER_SIZE-readBufferBegin;
+		backlog.wrappedSize = wholeSize-backlog.size;
+	}
+
+	// swap the read buffers, carrying a partial item over to the fresh buffer
+	Byte partialItemData[sizeof(Type)];
+	std::size_t partialSize = readBufferSize-wholeSize;
+	for (std::size_t i = 0; i < partialSize; i++)
+		partialItemData[i] = data[(readBufferBegin+wholeSize+i)%READ_BUFFER_SIZE];
+	readBufferIndex = (readBufferIndex+1)%READ_BUFFER_COUNT;
+	readBufferDrained = true;
+	readBufferBegin = 0;
+	readBufferSize = 0;
+	copyToReadBuffer(partialItemData, partialSize);
+	return true;
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::release() {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	readBufferDrained = false;
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::setReadBatching(std::size_t minimumBytes, uint32_t maximumLatency) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	readBatchingMinimumBytes = minimumBytes;
+	readBatchingMaximumLatency = maximumLatency;
+}
+
+template <class Type, class Config>
+template <class BeginIterator>
+void SerialBasic<Type, Config>::write(BeginIterator beginIterator, std::size_t size) {
+
+	// the write mutex is not held while writing, so that the io service thread is never blocked by a paced write
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(writeMutex);
+		while (writing)
+			writeCondition.wait(scoped_lock);
+		writing = true;
+	}
+	try {
+		paceWrite();
+		writeItems(beginIterator, size, std::is_convertible<BeginIterator, const Type*>());
+	} catch (...) {
+		finishWrite();
+		throw;
+	}
+	finishWrite();
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::asyncWrite(const Type* items, std::size_t size, WriteHandler writeHandler) {
+	boost::unique_lock<boost::mutex> scoped_lock(writeMutex);
+	if (asynchronousWrites.full())
+		throw boost::system::system_error(boost::system::errc::make_error_code(
+			boost::system::errc::no_buffer_space));
+	AsynchronousWrite asynchronousWrite = {items, size, writeHandler};
+	asynchronousWrites.push(asynchronousWrite);
+	if (writing == false) {
+		writing = true;
+		io.post(wrap([this]()->void{
+			setAsynchronousWrite();
+		}));
+	}
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::finishWrite() {
+
+	// queued asynchronous writes take over before other blocking writes
+	boost::unique_lock<boost::mutex> scoped_lock(writeMutex);
+	if (asynchronousWrites.empty() == false) {
+		io.post(wrap([this]()->void{
+			setAsynchronousWrite();
+		}));
+		return;
+	}
+	writing = false;
+	writeCondition.notify_all();
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::setAsynchronousWrite() {
+	uint32_t maximumTime;
+	{
+		boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+		maximumTime = outputQueueLimit;
+	}
+
+	// a full output queue is waited for with a timer, as opposed to blocking the io service thread
+	if (maximumTime != 0) {
+		boost::system::error_code queryError;
+		std::size_t queueSize = queryQueueSize(false, queryError);
+		uint32_t queueTime;
+		{
+			boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+			queueTime = (uint32_t)(queueSize*characterTime);
+		}
+		if (queueTime > maximumTime) {
+			writeTimer.expires_from_now(std::chrono::microseconds(queueTime-maximumTime));
+			writeTimer.async_wait(wrap([this](const boost::system::error_code& error)->void{
+				if (error == false)
+					setAsynchronousWrite();
+			}));
+			return;
+		}
+	}
+	AsynchronousWrite asynchronousWrite;
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(writeMutex);
+		asynchronousWrite = asynchronousWrites.front();
+	}
+	boost::asio::async_write(serial, boost::asio::buffer(asynchronousWrite.items, asynchronousWrite.size*sizeof(Type)),
+		wrap([this](const boost::system::error_code& error, std::size_t)->void{
+		AsynchronousWrite asynchronousWrite;
+		bool queued;
+		{
+			boost::unique_lock<boost::mutex> scoped_lock(writeMutex);
+			asynchronousWrite = asynchronousWrites.pop();
+			queued = asynchronousWrites.empty() == false;
+			if (queued == false) {
+				writing = false;
+				writeCondition.notify_all();
+			}
+		}
+		if (queued)
+			setAsynchronousWrite();
+		if (asynchronousWrite.writeHandler)
+			asynchronousWrite.writeHandler(error);
+	}));
+}
+
+template <class Type, class Config>
+std::size_t SerialBasic<Type, Config>::addReceiveHandler(ReceiveHandler receiveHandler) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	std::size_t handlerId = nextReceiveHandlerId++;
+	receiveHandlers[handlerId] = receiveHandler;
+	return handlerId;
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::removeReceiveHandler(std::size_t handlerId) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	receiveHandlers.erase(handlerId);
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::scheduleAsynchronousRead(std::size_t requestedSize, std::size_t size) {
+
+	// a full read suggests a burst, thus more is requested next time, whereas a mostly empty read suggests a trickle
+	inputQueueBacklog = size == requestedSize;
+	if (size == requestedSize)
+		readSize = (readSize*2 < MAX_READ_SIZE) ? readSize*2 : MAX_READ_SIZE;
+	else if (size*4 < requestedSize)
+		readSize = (readSize/2 > MIN_READ_SIZE) ? readSize/2 : MIN_READ_SIZE;
+
+	// the arrival rate in bytes per microsecond is averaged over the last several reads
+	Clock::time_point now = Clock::now();
+	double elapsedTime = std::chrono::duration<double, std::micro>(now-lastReadTime).count();
+	lastReadTime = now;
+	if (elapsedTime > 0.0)
+		arrivalRate = (arrivalRate*7.0+size/elapsedTime)/8.0;
+	if (readBatchingMinimumBytes == 0 || size >= readBatchingMinimumBytes) {
+		setAsynchronousRead();
+		return;
+	}
+
+	// wait for the missing bytes to arrive, at most for the maximum latency
+	double delay = (arrivalRate > 0.0) ? (readBatchingMinimumBytes-size)/arrivalRate : readBatchingMaximumLatency;
+	if (delay > readBatchingMaximumLatency)
+		delay = readBatchingMaximumLatency;
+	readTimer.expires_from_now(std::chrono::microseconds((int64_t)delay));
+	inputQueueBacklog = true;
+	readTimer.async_wait(wrap([this](const boost::system::error_code& error)->void{
+		if (error == false)
+			setAsynchronousRead();
+	}));
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::setNotification(std::size_t minimumItems, uint32_t maximumDelay, 
+	NotifyHandler notifyHandler) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	notifyMinimumItems = (minimumItems == 0) ? 1 : minimumItems;
+	notifyMaximumDelay = maximumDelay;
+	this->notifyHandler = notifyHandler;
+}
+
+template <class Type, class Config>
+std::size_t SerialBasic<Type, Config>::wait(uint32_t timeout) {
+	boost::system_time deadline = boost::get_system_time()+boost::posix_time::milliseconds(timeout);
+
+	// the sequence is taken before the buffer is checked, so a notification in between is not missed
+	uint64_t sequence;
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(notifyMutex);
+		sequence = notifySequence;
+	}
+	std::size_t items = available();
+	{
+		boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+		if (items >= notifyMinimumItems)
+			return items;
+	}
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(notifyMutex);
+		while (notifySequence == sequence)
+			if (notifyCondition.timed_wait(scoped_lock, deadline) == false)
+				break;
+	}
+	return available();
+}
+
+template <class Type, class Config>
+std::size_t SerialBasic<Type, Config>::wait(uint32_t timeout, std::size_t items) {
+	boost::system_time deadline = boost::get_system_time()+boost::posix_time::milliseconds(timeout);
+	while (true) {
+
+		// the sequence is taken before the buffer is checked, so a notification in between is not missed
+		uint64_t sequence;
+		{
+			boost::unique_lock<boost::mutex> scoped_lock(notifyMutex);
+			sequence = notifySequence;
+		}
+		std::size_t availableItems = available();
+		if (availableItems > items)
+			return availableItems;
+		boost::unique_lock<boost::mutex> scoped_lock(notifyMutex);
+		while (notifySequence == sequence)
+			if (notifyCondition.timed_wait(scoped_lock, deadline) == false)
+				return available();
+	}
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::updateNotification() {
+	std::size_t items = readBufferSize/sizeof(Type);
+	if (items >= notifyMinimumItems) {
+		notify();
+		return;
+	}
+	if (items == 0 || notifyTimerArmed)
+		return;
+
+	// the first item without a notification starts the delay
+	notifyTimerArmed = true;
+	notifyTimer.expires_from_now(std::chrono::microseconds(notifyMaximumDelay));
+	notifyTimer.async_wait(wrap([this](const boost::system::error_code& error)->void{
+		boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+
+		// a cancelled wait was already superseded by a notification
+		if (error == false) {
+			notifyTimerArmed = false;
+			if (readBufferSize >= sizeof(Type))
+				notify();
+		}
+	}));
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::notify() {
+	if (notifyTimerArmed) {
+		notifyTimer.cancel();
+		notifyTimerArmed = false;
+	}
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(notifyMutex);
+		notifySequence++;
+	}
+	notifyCondition.notify_all();
+	if (notifyHandler)
+		notifyHandler(readBufferSize/sizeof(Type));
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::setResynchronization(uint32_t gapCharacters) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	resynchronizationGap = gapCharacters;
+}
+
+template <class Type, class Config>
+uint64_t SerialBasic<Type, Config>::getDiscardedItems() {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	return discardedItems;
+}
+
+template <class Type, class Config>
+std::size_t SerialBasic<Type, Config>::getOutputQueueSize() {
+	boost::system::error_code error;
+	std::size_t size = queryQueueSize(false, error);
+	if (error)
+		throw boost::system::system_error(error);
+	return size;
+}
+
+template <class Type, class Config>
+uint32_t SerialBasic<Type, Config>::getOutputQueueTime() {
+	std::size_t size = getOutputQueueSize();
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	return (uint32_t)(size*characterTime);
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::waitTransmitted() {
+#if defined(__unix__) || defined(__APPLE__)
+	while (tcdrain(serial.native_handle()) != 0)
+		if (errno != EINTR)
+			throw boost::system::system_error(boost::system::error_code(errno, boost::system::system_category()));
+#elif defined(_WIN32)
+	if (FlushFileBuffers(serial.native_handle()) == 0)
+		throw boost::system::system_error(boost::system::error_code(GetLastError(), boost::system::system_category()));
+#else
+	throw boost::system::system_error(boost::system::errc::make_error_code(
+		boost::system::errc::operation_not_supported));
+#endif
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::asyncWaitTransmitted(TransmittedHandler transmittedHandler) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	if (transmittedHandlers.full())
+		throw boost::system::system_error(boost::system::errc::make_error_code(
+			boost::system::errc::no_buffer_space));
+	bool waiting = transmittedHandlers.empty() == false;
+	transmittedHandlers.push(transmittedHandler);
+	if (waiting == false)
+		scheduleTransmitCheck();
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::setOutputQueueLimit(uint32_t maximumTime) {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	outputQueueLimit = maximumTime;
+}
+
+template <class Type, class Config>
+std::size_t SerialBasic<Type, Config>::getInputQueueSize() {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	return inputQueueSize;
+}
+
+template <class Type, class Config>
+std::size_t SerialBasic<Type, Config>::getInputQueuePeak() {
+	boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+	std::size_t peak = inputQueuePeak;
+	inputQueuePeak = inputQueueSize;
+	return peak;
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::updateResynchronization() {
+
+	// every chunk restarts the gap, and a sequence number invalidates a wait that already completed
+	resynchronizationSequence++;
+	std::size_t partialSize = DECODED_READ_BUFFER ? partialItemSize : readBufferSize%sizeof(Type);
+	if (resynchronizationGap == 0 || partialSize == 0) {
+		resynchronizationTimer.cancel();
+		return;
+	}
+
+	// while reads are delayed by batching, data may wait in the operating system's buffer for the maximum latency
+	uint64_t sequence = resynchronizationSequence;
+	double gap = resynchronizationGap*characterTime+((readBatchingMinimumBytes != 0) ? readBatchingMaximumLatency : 0);
+	resynchronizationTimer.expires_from_now(std::chrono::microseconds((int64_t)gap));
+	resynchronizationTimer.async_wait(wrap([this, sequence](const boost::system::error_code& error)->void{
+		boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+		if (error || sequence != resynchronizationSequence)
+			return;
+		if (DECODED_READ_BUFFER) {
+			partialItemSize = 0;
+		} else {
+			if (readBufferSize%sizeof(Type) == 0)
+				return;
+			readBufferSize -= readBufferSize%sizeof(Type);
+		}
+		discardedItems++;
+	}));
+}
+
+template <class Type, class Config>
+std::size_t SerialBasic<Type, Config>::queryQueueSize(bool input, boost::system::error_code& error) {
+#if defined(__unix__) || defined(__APPLE__)
+	int size = 0;
+	if (ioctl(serial.native_handle(), input ? FIONREAD : TIOCOUTQ, &size) != 0) {
+		error = boost::system::error_code(errno, boost::system::system_category());
+		return 0;
+	}
+	return (std::size_t)size;
+#elif defined(_WIN32)
+	DWORD errors;
+	COMSTAT status;
+	if (ClearCommError(serial.native_handle(), &errors, &status) == 0) {
+		error = boost::system::error_code(GetLastError(), boost::system::system_category());
+		return 0;
+	}
+	return input ? status.cbInQue : status.cbOutQue;
+#else
+	error = boost::system::errc::make_error_code(boost::system::errc::operation_not_supported);
+	return 0;
+#endif
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::scheduleTransmitCheck() {
+
+	// the queue is checked again once it should have been transmitted, plus a character time for the last byte, which
+	// may still be in the UART when the queue is empty
+	boost::system::error_code error;
+	std::size_t size = queryQueueSize(false, error);
+	transmitTimer.expires_from_now(std::chrono::microseconds((int64_t)((size+1)*characterTime)));
+	transmitTimer.async_wait(wrap([this](const boost::system::error_code& error)->void{
+		if (error)
+			return;
+		SerialBasicFixedQueue<TransmittedHandler, MAX_TRANSMITTED_HANDLERS> handlers;
+		{
+			boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+			boost::system::error_code queryError;
+			if (queryQueueSize(false, queryError) != 0) {
+				scheduleTransmitCheck();
+				return;
+			}
+			while (transmittedHandlers.empty() == false)
+				handlers.push(transmittedHandlers.pop());
+		}
+
+		// the handlers are called unlocked, thus they may call asyncWaitTransmitted() again
+		while (handlers.empty() == false) {
+			TransmittedHandler transmittedHandler = handlers.pop();
+			if (transmittedHandler)
+				transmittedHandler();
+		}
+	}));
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::paceWrite() {
+	uint32_t maximumTime;
+	{
+		boost::unique_lock<boost::recursive_mutex> scoped_lock(recursiveMutex);
+		maximumTime = outputQueueLimit;
+	}
+
+	// the output queue exceeds the limit by at most one write, and it is transmitted meanwhile
+	while (maximumTime != 0) {
+		uint32_t queueTime = getOutputQueueTime();
+		if (queueTime <= maximumTime)
+			return;
+		boost::this_thread::sleep(boost::posix_time::microseconds(queueTime-maximumTime));
+	}
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::copyToReadBuffer(const Byte* source, std::size_t size) {
+	std::size_t bytesRemaining = READ_BUFFER_SIZE-readBufferSize;
+	std::size_t bytesToTransfer = (bytesRemaining < size) ? bytesRemaining : size;
+	std::size_t end = (readBufferBegin+readBufferSize)%READ_BUFFER_SIZE;
+	std::size_t firstSize = (READ_BUFFER_SIZE-end < bytesToTransfer) ? READ_BUFFER_SIZE-end : bytesToTransfer;
+	std::memmove(readBuffers[readBufferIndex].data()+end, source, firstSize);
+	std::memmove(readBuffers[readBufferIndex].data(), source+firstSize, bytesToTransfer-firstSize);
+	readBufferSize += bytesToTransfer;
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::decodeToReadBuffer(const Byte* source, std::size_t size) {
+
+	// complete the item left partial by the previous chunk
+	if (partialItemSize != 0) {
+		std::size_t bytesToTransfer = (sizeof(Type)-partialItemSize < size) ? sizeof(Type)-partialItemSize : size;
+		std::memcpy(partialItem+partialItemSize, source, bytesToTransfer);
+		partialItemSize += bytesToTransfer;
+		source += bytesToTransfer;
+		size -= bytesToTransfer;
+		if (partialItemSize != sizeof(Type))
+			return;
+		copyToReadBuffer(partialItem, sizeof(Type));
+		partialItemSize = 0;
+	}
+
+	// only whole items enter the read buffer, whose capacity is a multiple of sizeof(Type), thus items never straddle 
+	// the end of the buffer and items that do not fit are dropped whole
+	std::size_t wholeSize = size-size%sizeof(Type);
+	copyToReadBuffer(source, wholeSize);
+	std::memcpy(partialItem, source+wholeSize, size-wholeSize);
+	partialItemSize = size-wholeSize;
+}
+
+template <class Type, class Config>
+void SerialBasic<Type, Config>::copyFromReadBuffer(Byte* destination, std::size_t size) {
+	std::size_t firstSize = (READ_BUFFER_SIZE-readBufferBegin < size) ? READ_BUFFER_SIZE-readBufferBegin : size;
+	std::memcpy(destination, readBuffers[readBufferIndex].data()+readBufferBegin, firstSize);
+	std::memcpy(destination+firstSize, readBuffers[readBufferIndex].data(), size-firstSize);
+	readBufferBegin = (readBufferBegin+size)%READ_BUFFER_SIZE;
+	readBufferSize -= size;
+}
+
+template <class Type, class Config>
 template <class BeginIterator>
-void SerialBasic<Type>::write(BeginIterator beginIterator, std::size_t size) {
-	std::unique_ptr<Type[]> buffer(new Type[size]);
-	for (std::size_t i = 0; i < size; i++)
-		buffer.get()[i] = *(beginIterator++);
-	boost::asio::write(serial, boost::asio::buffer(buffer.get(), size*sizeof(Type)));
+void SerialBasic<Type, Config>::readItems(BeginIterator beginIterator, std::size_t size, std::true_type) {
+
+	// the items are saved to an array, thus they are copied directly
+	copyFromReadBuffer((Byte*)(Type*)beginIterator, size*sizeof(Type));
+}
+
+template <class Type, class Config>
+template <class BeginIterator>
+void SerialBasic<Type, Config>::readItems(BeginIterator beginIterator, std::size_t size, std::false_type) {
+	if (DECODED_READ_BUFFER) {
+
+		// the read buffer holds whole, aligned items, thus they are assigned in place
+		const Type* items = (const Type*)readBuffers[readBufferIndex].data();
+		std::size_t index = readBufferBegin/sizeof(Type);
+		for (std::size_t i = 0; i < size; i++)
+			*(beginIterator++) = items[(index+i)%(READ_BUFFER_SIZE/sizeof(Type))];
+		readBufferBegin = (readBufferBegin+size*sizeof(Type))%READ_BUFFER_SIZE;
+		readBufferSize -= size*sizeof(Type);
+		return;
+	}
+	for (std::size_t i = 0; i < size; i++) {
+		Type item;
+		copyFromReadBuffer((Byte*)&item, sizeof(Type));
+		*(beginIterator++) = item;
+	}
+}
+
+template <class Type, class Config>
+template <class BeginIterator>
+void SerialBasic<Type, Config>::writeItems(BeginIterator beginIterator, std::size_t size, std::true_type) {
+
+	// the items are taken from an array, thus they are written without staging
+	boost::asio::write(serial, boost::asio::buffer((const Type*)beginIterator, size*sizeof(Type)));
+}
+
+template <class Type, class Config>
+template <class BeginIterator>
+void SerialBasic<Type, Config>::writeItems(BeginIterator beginIterator, std::size_t size, std::false_type) {
+	const std::size_t itemsPerWrite = WRITE_BUFFER_SIZE/sizeof(Type);
+	while (size != 0) {
+		std::size_t itemsToTransfer = (itemsPerWrite < size) ? itemsPerWrite : size;
+		for (std::size_t i = 0; i < itemsToTransfer; i++)
+			writeBuffer[i] = *(beginIterator++);
+		boost::asio::write(serial, boost::asio::buffer(writeBuffer, itemsToTransfer*sizeof(Type)));
+		size -= itemsToTransfer;
+	}
 }
 
 #endif
\ No newline at end of file
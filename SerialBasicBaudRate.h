@@ -0,0 +1,355 @@
+#ifndef SERIAL_BASIC_BAUD_RATE_H_
+#define SERIAL_BASIC_BAUD_RATE_H_
+
+#include "SerialBasic.h"
+#include "SerialBasicMessages.h"
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <cstring>
+
+/**
+ * @file SerialBasicBaudRate.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicBaudRateNegotiation;
+
+/**
+ * \brief Negotiates the fastest baud rate that works between two SerialBasic objects at the ends of a link
+ *
+ * Both ends open the link at a common, safe baud rate. One end calls negotiate() and the other end calls respond().
+ * The handshake is made of messages of SerialBasicMessages with a CRC:
+ *
+ *	- PROPOSE (initiator): the initiator's faster baud rates and its fallback time. The responder answers with ACCEPT
+ *	  and the fastest of them that it supports, then switches to it once the answer was transmitted.
+ *	- PROBE (initiator, at the new baud rate): a test pattern that the responder echoes with PROBE_ACK.
+ *	- COMMIT (initiator, at the new baud rate): acknowledged by the responder with COMMIT_ACK. The initiator keeps the
+ *	  new baud rate once it receives COMMIT_ACK, and the responder keeps it once it received COMMIT. The responder
+ *	  answers repeated COMMITs until the initiator stops sending them, so that a lost COMMIT_ACK is sent again.
+ *
+ * If the probe is not echoed, or no COMMIT is acknowledged, the initiator falls back to the previous baud rate and
+ * proposes the next slower one once the fallback time passed. The responder falls back as well if it does not receive
+ * a COMMIT within the fallback time. Thus the ends only disagree if every COMMIT_ACK is lost while a COMMIT arrived.
+ *
+ * While a negotiation is in progress, the SerialBasic object should neither be read nor written by other means, and
+ * the other end should not transmit anything else.
+ */
+template <class Type, class Config>
+class SerialBasicBaudRateNegotiation {
+public:
+
+	/**
+	 * \brief Create a negotiation for a SerialBasic object
+	 *
+	 * @param port The SerialBasic object. It must outlive the SerialBasicBaudRateNegotiation object.
+	 * @param baudRates The baud rates supported by this end of the link.
+	 */
+	SerialBasicBaudRateNegotiation(SerialBasic<Type, Config>& port, const std::vector<uint32_t>& baudRates =
+		std::vector<uint32_t>{921600, 460800, 230400, 115200});
+
+	/**
+	 * \brief Negotiate a faster baud rate with the other end, which calls respond() (blocking)
+	 *
+	 * @param timeout The maximum time in milliseconds to wait for each answer of the other end.
+	 * @return The baud rate in use afterwards, which is the current one if no faster baud rate works.
+	 * @throw boost::system::system_error Thrown if the baud rate could not be set on the serial port.
+	 */
+	uint32_t negotiate(uint32_t timeout = 1000);
+
+	/**
+	 * \brief Wait for the other end to call negotiate(), and take part in the negotiation (blocking)
+	 *
+	 * @param timeout The maximum time in milliseconds to wait for the proposal, and for each further message.
+	 * @return The baud rate in use afterwards, which is the current one if no proposal was received or if the
+	 * negotiation failed.
+	 * @throw boost::system::system_error Thrown if the baud rate could not be set on the serial port.
+	 */
+	uint32_t respond(uint32_t timeout = 10000);
+
+	/**
+	 * \brief Get the amount of times a baud rate was abandoned
+	 *
+	 * @return The amount of times this end fell back to the previous baud rate because the new one did not work.
+	 */
+	uint64_t getFallbacks();
+private:
+	typedef std::chrono::steady_clock Clock;
+	typedef SerialBasicMessages<Type, Config> Messages;
+	enum PacketType {
+		PROPOSE = 1,
+		ACCEPT = 2,
+		PROBE = 3,
+		PROBE_ACK = 4,
+		COMMIT = 5,
+		COMMIT_ACK = 6
+	};
+	const static std::size_t HEADER_SIZE = 5;
+	const static std::size_t MAX_PACKET_SIZE = 64;
+	const static std::size_t MAX_BAUD_RATES = (MAX_PACKET_SIZE-HEADER_SIZE-5)/4;
+	const static std::size_t PROBE_SIZE = 16;
+	const static uint32_t ATTEMPTS = 3;
+	const static uint32_t SWITCH_DELAY = 50;
+
+	// alternating bits, long runs and single bits, which are the first to fail at a baud rate the link does not carry
+	static const uint8_t PROBE_PATTERN[PROBE_SIZE];
+	SerialBasic<Type, Config>& port;
+	std::vector<uint32_t> baudRates;
+	uint32_t sessionId;
+	uint64_t fallbacks;
+	void send(Messages& messages, uint8_t type, const uint8_t* data = NULL, std::size_t size = 0);
+	bool receive(Messages& messages, uint8_t type, std::vector<uint8_t>& data, uint32_t timeout);
+	void switchBaudRate(uint32_t baudRate, uint32_t delay);
+	static void putValue(uint8_t* data, uint32_t value);
+	static uint32_t getValue(const uint8_t* data);
+};
+
+template <class Type, class Config>
+SerialBasicBaudRateNegotiation<Type, Config>::SerialBasicBaudRateNegotiation(SerialBasic<Type, Config>& port,
+	const std::vector<uint32_t>& baudRates) : port(port), baudRates(baudRates), sessionId(0), fallbacks(0) {
+	std::sort(this->baudRates.begin(), this->baudRates.end(), std::greater<uint32_t>());
+	if (this->baudRates.size() > MAX_BAUD_RATES)
+		this->baudRates.resize(MAX_BAUD_RATES);
+}
+
+template <class Type, class Config>
+uint32_t SerialBasicBaudRateNegotiation<Type, Config>::negotiate(uint32_t timeout) {
+	uint32_t currentBaudRate = port.getBaudRate();
+	std::vector<uint32_t> candidates;
+	for (std::size_t i = 0; i < baudRates.size(); i++)
+		if (baudRates[i] > currentBaudRate)
+			candidates.push_back(baudRates[i]);
+
+	// the other end keeps a new baud rate without a commit only as long as the probes and commits may take
+	uint32_t fallbackTime = 2*ATTEMPTS*timeout+SWITCH_DELAY;
+	std::vector<uint8_t> data;
+	while (candidates.empty() == false) {
+
+		// a new session for every proposal, so that late answers to an earlier proposal are ignored
+		sessionId = (uint32_t)Clock::now().time_since_epoch().count()^(sessionId*16777619u);
+		uint8_t proposal[MAX_PACKET_SIZE-HEADER_SIZE];
+		putValue(proposal, fallbackTime);
+		proposal[4] = (uint8_t)candidates.size();
+		for (std::size_t i = 0; i < candidates.size(); i++)
+			putValue(proposal+5+4*i, candidates[i]);
+		bool answered = false;
+		{
+			Messages messages(port, MAX_PACKET_SIZE, true);
+			for (std::size_t attempt = 0; attempt < ATTEMPTS && answered == false; attempt++) {
+				send(messages, PROPOSE, proposal, 5+4*candidates.size());
+				answered = receive(messages, ACCEPT, data, timeout) && data.size() == 4;
+			}
+		}
+
+		// the other end did not answer, or supports none of the proposed baud rates
+		uint32_t baudRate = answered ? getValue(data.data()) : 0;
+		if (std::find(candidates.begin(), candidates.end(), baudRate) == candidates.end())
+			return currentBaudRate;
+
+		// the other end switches once its answer was transmitted, which is well within the delay
+		switchBaudRate(baudRate, SWITCH_DELAY);
+		Clock::time_point switchTime = Clock::now();
+		{
+			Messages messages(port, MAX_PACKET_SIZE, true);
+			bool probed = false;
+			for (std::size_t attempt = 0; attempt < ATTEMPTS && probed == false; attempt++) {
+				send(messages, PROBE, PROBE_PATTERN, PROBE_SIZE);
+				probed = receive(messages, PROBE_ACK, data, timeout) && data.size() == PROBE_SIZE &&
+					std::memcmp(data.data(), PROBE_PATTERN, PROBE_SIZE) == 0;
+			}
+
+			// the other end proved it receives and transmits at the new baud rate, but it only keeps the baud rate once
+			// it received a commit, thus the baud rate is abandoned unless the commit is acknowledged
+			for (std::size_t attempt = 0; attempt < ATTEMPTS && probed; attempt++) {
+				send(messages, COMMIT);
+				if (receive(messages, COMMIT_ACK, data, timeout))
+					return baudRate;
+			}
+		}
+
+		// the new baud rate does not work, thus the next slower one is proposed once the other end fell back as well
+		fallbacks++;
+		switchBaudRate(currentBaudRate, 0);
+		Clock::duration elapsedTime = Clock::now()-switchTime;
+		if (elapsedTime < std::chrono::milliseconds(fallbackTime+SWITCH_DELAY))
+			boost::this_thread::sleep(boost::posix_time::milliseconds(fallbackTime+SWITCH_DELAY-
+				std::chrono::duration_cast<std::chrono::milliseconds>(elapsedTime).count()));
+		candidates.erase(std::find(candidates.begin(), candidates.end(), baudRate));
+	}
+	return currentBaudRate;
+}
+
+template <class Type, class Config>
+uint32_t SerialBasicBaudRateNegotiation<Type, Config>::respond(uint32_t timeout) {
+	uint32_t currentBaudRate = port.getBaudRate();
+	std::vector<uint8_t> data;
+
+	// after a fallback, the initiator proposes the next slower baud rate
+	while (true) {
+		uint32_t fallbackTime;
+		uint32_t baudRate = 0;
+		{
+			Messages messages(port, MAX_PACKET_SIZE, true);
+			if (receive(messages, PROPOSE, data, timeout) == false)
+				return currentBaudRate;
+			if (data.size() < 5 || data.size() != 5+4*(std::size_t)data[4])
+				continue;
+			fallbackTime = getValue(data.data());
+
+			// the initiator proposes its baud rates sorted, thus the first one supported here is the fastest
+			for (std::size_t i = 0; i < data[4] && baudRate == 0; i++)
+				if (std::find(baudRates.begin(), baudRates.end(), getValue(&data[5+4*i])) != baudRates.end())
+					baudRate = getValue(&data[5+4*i]);
+			uint8_t answer[4];
+			putValue(answer, baudRate);
+			send(messages, ACCEPT, answer, 4);
+			if (baudRate == 0)
+				return currentBaudRate;
+		}
+
+		// the answer is transmitted before the baud rate changes, with a margin for a transmitter FIFO that the driver
+		// does not wait for
+		switchBaudRate(baudRate, SWITCH_DELAY/5);
+		{
+			Messages messages(port, MAX_PACKET_SIZE, true);
+			Clock::time_point deadline = Clock::now()+std::chrono::milliseconds(fallbackTime);
+
+			// the initiator repeats a commit that is not acknowledged within its timeout, which follows from the
+			// fallback time, thus once a commit is answered, a quiet period of twice that timeout ends the negotiation
+			Clock::duration quietTime = std::chrono::milliseconds((fallbackTime > SWITCH_DELAY) ?
+				(fallbackTime-SWITCH_DELAY)/ATTEMPTS : 0);
+			bool probed = false;
+			bool committed = false;
+			while (Clock::now() < deadline) {
+				const uint8_t* message;
+				std::size_t size;
+				if (messages.receive(message, size) == false) {
+					port.wait(1, port.available());
+					continue;
+				}
+				if (size < HEADER_SIZE || getValue(message+1) != sessionId)
+					continue;
+				if (message[0] == PROBE) {
+					probed = true;
+					send(messages, PROBE_ACK, message+HEADER_SIZE, size-HEADER_SIZE);
+				} else if (message[0] == COMMIT && probed) {
+					send(messages, COMMIT_ACK);
+					committed = true;
+					deadline = Clock::now()+quietTime;
+				}
+			}
+			if (committed)
+				return baudRate;
+		}
+
+		// the initiator gave up on the new baud rate
+		fallbacks++;
+		switchBaudRate(currentBaudRate, 0);
+	}
+}
+
+template <class Type, class Config>
+uint64_t SerialBasicBaudRateNegotiation<Type, Config>::getFallbacks() {
+	return fallbacks;
+}
+
+template <class Type, class Config>
+void SerialBasicBaudRateNegotiation<Type, Config>::send(Messages& messages, uint8_t type, const uint8_t* data,
+	std::size_t size) {
+	uint8_t packet[MAX_PACKET_SIZE];
+	packet[0] = type;
+	putValue(packet+1, sessionId);
+	if (size != 0)
+		std::memcpy(packet+HEADER_SIZE, data, size);
+
+	// a failed write is handled like a lost packet
+	try {
+		messages.send(packet, HEADER_SIZE+size);
+	} catch (boost::system::system_error&) {
+	}
+}
+
+template <class Type, class Config>
+bool SerialBasicBaudRateNegotiation<Type, Config>::receive(Messages& messages, uint8_t type,
+	std::vector<uint8_t>& data, uint32_t timeout) {
+	Clock::time_point deadline = Clock::now()+std::chrono::milliseconds(timeout);
+	while (true) {
+		const uint8_t* message;
+		std::size_t size;
+		while (messages.receive(message, size)) {
+
+			// the responder adopts the session of the proposal, and afterwards only messages of that session count
+			if (size < HEADER_SIZE || message[0] != type || (type != PROPOSE && getValue(message+1) != sessionId))
+				continue;
+			sessionId = getValue(message+1);
+			data.assign(message+HEADER_SIZE, message+size);
+			return true;
+		}
+		Clock::time_point now = Clock::now();
+		if (now >= deadline)
+			return false;
+		port.wait((uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(deadline-now).count()+1,
+			port.available());
+	}
+}
+
+template <class Type, class Config>
+void SerialBasicBaudRateNegotiation<Type, Config>::switchBaudRate(uint32_t baudRate, uint32_t delay) {
+
+	// the last message is transmitted at the previous baud rate, or is at least given the time to be if the output
+	// queue cannot be waited for
+	try {
+		port.waitTransmitted();
+	} catch (boost::system::system_error&) {
+		delay += (uint32_t)((MAX_PACKET_SIZE+8)*10*1000/port.getBaudRate());
+	}
+	boost::this_thread::sleep(boost::posix_time::milliseconds(delay));
+	port.setBaudRate(baudRate);
+
+	// whatever was received around the change is garbage, including a partial item
+	const typename SerialBasic<Type, Config>::Byte* data;
+	std::size_t size;
+	while ((size = port.peek(data)) != 0)
+		port.consume(size);
+}
+
+template <class Type, class Config>
+void SerialBasicBaudRateNegotiation<Type, Config>::putValue(uint8_t* data, uint32_t value) {
+	for (std::size_t i = 0; i < 4; i++)
+		data[i] = (uint8_t)(value >> (8*i));
+}
+
+template <class Type, class Config>
+uint32_t SerialBasicBaudRateNegotiation<Type, Config>::getValue(const uint8_t* data) {
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+template <class Type, class Config>
+const uint8_t SerialBasicBaudRateNegotiation<Type, Config>::PROBE_PATTERN[PROBE_SIZE] = {0x55, 0xAA, 0x00, 0xFF, 0x0F,
+	0xF0, 0x33, 0xCC, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+
+#endif
\ No newline at end of file
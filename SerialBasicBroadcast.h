@@ -0,0 +1,316 @@
+#ifndef SERIAL_BASIC_BROADCAST_H_
+#define SERIAL_BASIC_BROADCAST_H_
+
+#include "SerialBasic.h"
+#include <vector>
+#include <cstring>
+
+/**
+ * @file SerialBasicBroadcast.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicBroadcast;
+
+/**
+ * \brief Broadcasts the receive stream of a SerialBasic object to many subscribers within one process
+ *
+ * SerialBasic::read() is destructive, thus only one consumer can read each item. SerialBasicBroadcast saves every
+ * received byte once in a ring, and each Subscriber holds its own cursor over the ring, thus every subscriber reads every
+ * item and the items are never copied for each subscriber. Subscribers can access items in place with visit().
+ *
+ * A subscriber that lags by more than its lag limit, or by more than the ring's capacity, has its drop policy applied.
+ * The lag limit and drop policy of each subscriber are independent, thus a slow subscriber never affects the others.
+ */
+template <class Type, class Config>
+class SerialBasicBroadcast {
+public:
+	typedef typename SerialBasic<Type, Config>::Byte Byte;
+
+	/**
+	 * \brief What to do with a subscriber that lags by more than its lag limit
+	 */
+	enum DropPolicy {
+		DROP_OLDEST,	/**< The subscriber skips its oldest items until it is within its lag limit */
+		DETACH			/**< The subscriber is detached and reads nothing further */
+	};
+
+	/**
+	 * \brief A cursor over the broadcast's ring
+	 *
+	 * Each Subscriber object is intended to be used by a single thread.
+	 */
+	class Subscriber {
+	public:
+
+		/**
+		 * \brief Unsubscribe
+		 */
+		~Subscriber();
+
+		/**
+		 * \brief Get the amount of items that can be read
+		 *
+		 * @return The amount of unread items, which is also the subscriber's current lag.
+		 */
+		std::size_t available();
+
+		/**
+		 * \brief Read items (non-blocking)
+		 *
+		 * @param beginIterator The starting location of where the data is saved.
+		 * @param size The maximum amount of items to copy.
+		 * @return The actual amount of items saved.
+		 */
+		template <class BeginIterator>
+		std::size_t read(BeginIterator beginIterator, std::size_t size);
+
+		/**
+		 * \brief Access unread items in place (non-blocking)
+		 *
+		 * The visitor is called with (const Type* items, std::size_t count) up to twice, because the ring wraps. The ring
+		 * is locked while the visitor is running, thus the visitor should return quickly.
+		 *
+		 * @param visitor The visitor.
+		 * @param size The maximum amount of items to visit.
+		 * @return The amount of items visited, which are consumed.
+		 */
+		template <class Visitor>
+		std::size_t visit(Visitor visitor, std::size_t size);
+
+		/**
+		 * \brief Get the largest lag observed
+		 *
+		 * @return The largest amount of unread items observed when data was received.
+		 */
+		std::size_t getMaxLag();
+
+		/**
+		 * \brief Get the amount of items dropped
+		 *
+		 * @return The amount of items skipped because of the drop policy.
+		 */
+		uint64_t getDroppedItems();
+
+		/**
+		 * \brief Check whether the subscriber is detached
+		 *
+		 * @return True if the subscriber was detached by the DETACH drop policy.
+		 */
+		bool isDetached();
+	private:
+		friend class SerialBasicBroadcast;
+		SerialBasicBroadcast& broadcast;
+		DropPolicy dropPolicy;
+		uint64_t lagLimit;
+		uint64_t cursor;
+		std::size_t maxLag;
+		uint64_t droppedItems;
+		bool detached;
+		Subscriber(SerialBasicBroadcast& broadcast, DropPolicy dropPolicy, std::size_t lagLimit);
+	};
+
+	/**
+	 * \brief Broadcast every chunk received by port
+	 *
+	 * @param port The SerialBasic object whose receive stream is broadcasted. It must outlive the SerialBasicBroadcast
+	 * object.
+	 * @param capacity The capacity of the ring in items.
+	 */
+	SerialBasicBroadcast(SerialBasic<Type, Config>& port, std::size_t capacity = 4096);
+
+	/**
+	 * \brief Stop broadcasting
+	 *
+	 * All subscribers must be destroyed before the SerialBasicBroadcast object.
+	 */
+	~SerialBasicBroadcast();
+
+	/**
+	 * \brief Create a subscriber
+	 *
+	 * The subscriber starts at the current end of the ring, thus it only reads items received after it was created.
+	 *
+	 * @param dropPolicy The policy applied when the subscriber lags by more than lagLimit.
+	 * @param lagLimit The maximum amount of unread items. A lag limit of 0, or one larger than the ring's capacity, is
+	 * replaced by the ring's capacity.
+	 * @return The subscriber.
+	 */
+	std::unique_ptr<Subscriber> subscribe(DropPolicy dropPolicy = DROP_OLDEST, std::size_t lagLimit = 0);
+private:
+	boost::mutex mutex;
+	SerialBasic<Type, Config>& port;
+	std::size_t capacity;
+	std::unique_ptr<Byte[]> ring;
+	uint64_t writeSequence;
+	std::vector<Subscriber*> subscribers;
+	std::size_t receiveHandlerId;
+	void publish(const Byte* data, std::size_t size);
+};
+
+template <class Type, class Config>
+SerialBasicBroadcast<Type, Config>::Subscriber::Subscriber(SerialBasicBroadcast& broadcast, DropPolicy dropPolicy,
+	std::size_t lagLimit) : broadcast(broadcast), dropPolicy(dropPolicy), lagLimit(lagLimit), maxLag(0),
+	droppedItems(0), detached(false) {
+		cursor = broadcast.writeSequence-broadcast.writeSequence%sizeof(Type);
+}
+
+template <class Type, class Config>
+SerialBasicBroadcast<Type, Config>::Subscriber::~Subscriber() {
+	boost::unique_lock<boost::mutex> scoped_lock(broadcast.mutex);
+	for (auto subscriber = broadcast.subscribers.begin(); subscriber != broadcast.subscribers.end(); subscriber++) {
+		if (*subscriber == this) {
+			broadcast.subscribers.erase(subscriber);
+			break;
+		}
+	}
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicBroadcast<Type, Config>::Subscriber::available() {
+	boost::unique_lock<boost::mutex> scoped_lock(broadcast.mutex);
+	if (detached)
+		return 0;
+	return (std::size_t)((broadcast.writeSequence-cursor)/sizeof(Type));
+}
+
+template <class Type, class Config>
+template <class BeginIterator>
+std::size_t SerialBasicBroadcast<Type, Config>::Subscriber::read(BeginIterator beginIterator, std::size_t size) {
+	return visit([&](const Type* items, std::size_t count)->void{
+		beginIterator = std::copy(items, items+count, beginIterator);
+	}, size);
+}
+
+template <class Type, class Config>
+template <class Visitor>
+std::size_t SerialBasicBroadcast<Type, Config>::Subscriber::visit(Visitor visitor, std::size_t size) {
+	boost::unique_lock<boost::mutex> scoped_lock(broadcast.mutex);
+	if (detached)
+		return 0;
+	std::size_t numberOfCompletedItems = (std::size_t)((broadcast.writeSequence-cursor)/sizeof(Type));
+	std::size_t itemsToTransfer = (numberOfCompletedItems < size) ? numberOfCompletedItems : size;
+	if (itemsToTransfer == 0)
+		return 0;
+
+	// items never straddle the end of the ring, since the capacity is a multiple of sizeof(Type)
+	const Type* items = (const Type*)broadcast.ring.get();
+	std::size_t position = (std::size_t)((cursor/sizeof(Type))%broadcast.capacity);
+	std::size_t firstCount = (broadcast.capacity-position < itemsToTransfer) ?
+		broadcast.capacity-position :
+		itemsToTransfer;
+	visitor(items+position, firstCount);
+	if (firstCount < itemsToTransfer)
+		visitor(items, itemsToTransfer-firstCount);
+	cursor += itemsToTransfer*sizeof(Type);
+	return itemsToTransfer;
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicBroadcast<Type, Config>::Subscriber::getMaxLag() {
+	boost::unique_lock<boost::mutex> scoped_lock(broadcast.mutex);
+	return maxLag;
+}
+
+template <class Type, class Config>
+uint64_t SerialBasicBroadcast<Type, Config>::Subscriber::getDroppedItems() {
+	boost::unique_lock<boost::mutex> scoped_lock(broadcast.mutex);
+	return droppedItems;
+}
+
+template <class Type, class Config>
+bool SerialBasicBroadcast<Type, Config>::Subscriber::isDetached() {
+	boost::unique_lock<boost::mutex> scoped_lock(broadcast.mutex);
+	return detached;
+}
+
+template <class Type, class Config>
+SerialBasicBroadcast<Type, Config>::SerialBasicBroadcast(SerialBasic<Type, Config>& port, std::size_t capacity) :
+	port(port), capacity(capacity), ring(new Byte[capacity*sizeof(Type)]), writeSequence(0) {
+		receiveHandlerId = port.addReceiveHandler([this](const Byte* data, std::size_t size)->void{
+			publish(data, size);
+		});
+}
+
+template <class Type, class Config>
+SerialBasicBroadcast<Type, Config>::~SerialBasicBroadcast() {
+	port.removeReceiveHandler(receiveHandlerId);
+}
+
+template <class Type, class Config>
+std::unique_ptr<typename SerialBasicBroadcast<Type, Config>::Subscriber> SerialBasicBroadcast<Type, Config>::subscribe(
+	DropPolicy dropPolicy, std::size_t lagLimit) {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	if (lagLimit == 0 || lagLimit > capacity)
+		lagLimit = capacity;
+	std::unique_ptr<Subscriber> subscriber(new Subscriber(*this, dropPolicy, lagLimit));
+	subscribers.push_back(subscriber.get());
+	return subscriber;
+}
+
+template <class Type, class Config>
+void SerialBasicBroadcast<Type, Config>::publish(const Byte* data, std::size_t size) {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	std::size_t ringSize = capacity*sizeof(Type);
+
+	// only the last capacity items of a large chunk survive
+	if (size > ringSize) {
+		writeSequence += size-ringSize;
+		data += size-ringSize;
+		size = ringSize;
+	}
+
+	// apply the drop policy of every subscriber that would lag by more than its lag limit
+	uint64_t end = writeSequence+size;
+	for (auto iterator = subscribers.begin(); iterator != subscribers.end(); iterator++) {
+		Subscriber& subscriber = **iterator;
+		if (subscriber.detached)
+			continue;
+
+		// a trailing partial item already occupies the slot of an item in the ring
+		uint64_t lag = (end-subscriber.cursor+sizeof(Type)-1)/sizeof(Type);
+		if (lag > subscriber.lagLimit) {
+			if (subscriber.dropPolicy == DETACH) {
+				subscriber.detached = true;
+				continue;
+			}
+			subscriber.droppedItems += lag-subscriber.lagLimit;
+			subscriber.cursor += (lag-subscriber.lagLimit)*sizeof(Type);
+			lag = subscriber.lagLimit;
+		}
+		if (lag > subscriber.maxLag)
+			subscriber.maxLag = (std::size_t)lag;
+	}
+
+	// save the chunk
+	std::size_t position = (std::size_t)(writeSequence%ringSize);
+	std::size_t firstSize = (ringSize-position < size) ? ringSize-position : size;
+	std::memcpy(ring.get()+position, data, firstSize);
+	std::memcpy(ring.get(), data+firstSize, size-firstSize);
+	writeSequence = end;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,374 @@
+#ifndef SERIAL_BASIC_DAEMON_H_
+#define SERIAL_BASIC_DAEMON_H_
+
+#include "SerialBasic.h"
+#include <deque>
+#include <set>
+#include <vector>
+#include <cstdio>
+
+/**
+ * @file SerialBasicDaemon.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+#if defined(BOOST_ASIO_HAS_LOCAL_SOCKETS)
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicDaemon;
+
+/**
+ * \brief Shares a single SerialBasic port with many local client processes over a UNIX domain socket
+ *
+ * Only one process can own a serial port, thus SerialBasicDaemon owns the port on behalf of every client connected to
+ * its socket. Every chunk of bytes received from the serial port is sent to all of the connected clients. The chunk is
+ * saved once and shared by the clients' queues, as opposed to copied for each client.
+ *
+ * Clients write to the serial port by sending messages to the socket. Each message is a uint32_t in native byte order
+ * specifying the size of the message in bytes, followed by the message itself. The size must be a multiple of
+ * sizeof(Type) and no larger than MAX_MESSAGE_SIZE, otherwise the client is disconnected. Messages from all clients are
+ * merged into a single queue and each message is written to the serial port with a single call to SerialBasic::write,
+ * thus a message is never interleaved with the data of another message.
+ *
+ * A client that does not read its data fast enough cannot stall the other clients. Once the amount of data queued for
+ * a client exceeds the client queue limit, the slow client policy is applied to that client alone. Clients that write
+ * faster than the serial port transmits are slowed down instead: once the messages queued for the serial port exceed
+ * the write queue limit, messages are no longer read from the clients' sockets until the queue drains.
+ *
+ * SerialBasicDaemon is only available on operating systems for which boost supports local sockets.
+ */
+template <class Type, class Config>
+class SerialBasicDaemon {
+public:
+	typedef typename SerialBasic<Type, Config>::Byte Byte;
+
+	/**
+	 * \brief What to do with a client whose queue exceeds the client queue limit
+	 */
+	enum SlowClientPolicy {
+		DROP_DATA,			/**< Received data is dropped for the slow client until its queue drains */
+		DISCONNECT_CLIENT	/**< The slow client is disconnected */
+	};
+
+	const static std::size_t MAX_MESSAGE_SIZE = 65536;
+
+	/**
+	 * \brief Start sharing port on the UNIX domain socket at socketPath
+	 *
+	 * @param port The SerialBasic object to share. It must outlive the SerialBasicDaemon object.
+	 * @param socketPath The path of the socket. Any existing file at this path is removed.
+	 * @param clientQueueLimit The maximum amount of bytes queued for a single client.
+	 * @param slowClientPolicy The policy applied to a client whose queue exceeds clientQueueLimit.
+	 * @param writeQueueLimit The amount of bytes queued for the serial port above which messages are no longer read
+	 * from the clients.
+	 * @throw boost::system::system_error Thrown if the socket could not be created.
+	 */
+	SerialBasicDaemon(SerialBasic<Type, Config>& port, const std::string& socketPath,
+		std::size_t clientQueueLimit = 65536, SlowClientPolicy slowClientPolicy = DROP_DATA, 
+		std::size_t writeQueueLimit = 65536);
+
+	/**
+	 * \brief Disconnect all clients and remove the socket
+	 */
+	~SerialBasicDaemon();
+
+	/**
+	 * \brief Get the amount of connected clients
+	 *
+	 * @return The amount of connected clients.
+	 */
+	std::size_t getClientCount();
+
+	/**
+	 * \brief Get the total amount of bytes dropped for slow clients
+	 *
+	 * @return The amount of dropped bytes, summed over all clients.
+	 */
+	std::size_t getDroppedBytes();
+
+	/**
+	 * \brief Get boost error code
+	 *
+	 * The error code is set if writing a client's message to the serial port failed.
+	 *
+	 * @return The boost error code.
+	 */
+	boost::system::error_code& getErrorCode();
+private:
+	typedef boost::asio::local::stream_protocol Protocol;
+	typedef std::shared_ptr<const std::vector<Byte> > Chunk;
+	struct Client {
+		Protocol::socket socket;
+		std::deque<Chunk> queue;
+		std::size_t queuedBytes;
+		bool writing;
+		uint32_t messageSize;
+		std::vector<Byte> message;
+		Client(boost::asio::io_service& io) : socket(io), queuedBytes(0), writing(false), messageSize(0) {}
+	};
+	typedef std::shared_ptr<Client> ClientPointer;
+	SerialBasic<Type, Config>& port;
+	std::string socketPath;
+	std::size_t clientQueueLimit;
+	SlowClientPolicy slowClientPolicy;
+	boost::mutex mutex;
+	boost::condition_variable writeCondition;
+	std::size_t writeQueueLimit;
+	std::deque<std::vector<Byte> > writeQueue;
+	std::size_t writeQueueBytes;
+	std::vector<ClientPointer> pausedClients;
+	bool stopping;
+	std::set<ClientPointer> clients;
+	std::size_t droppedBytes;
+	boost::system::error_code errorCode;
+	boost::asio::io_service io;
+	boost::asio::io_service::work work_;
+	Protocol::acceptor acceptor;
+	std::size_t receiveHandlerId;
+	boost::thread thread_;
+	boost::thread writeThread;
+	void setAsynchronousAccept();
+	void setAsynchronousReadSize(ClientPointer client);
+	void setAsynchronousReadMessage(ClientPointer client);
+	void setAsynchronousWrite(ClientPointer client);
+	void broadcast(Chunk chunk);
+	void disconnect(ClientPointer client);
+	void writeMessages();
+};
+
+template <class Type, class Config>
+SerialBasicDaemon<Type, Config>::SerialBasicDaemon(SerialBasic<Type, Config>& port, const std::string& socketPath,
+	std::size_t clientQueueLimit, SlowClientPolicy slowClientPolicy, std::size_t writeQueueLimit) :
+	port(port), socketPath(socketPath), clientQueueLimit(clientQueueLimit), slowClientPolicy(slowClientPolicy),
+	writeQueueLimit(writeQueueLimit), writeQueueBytes(0), stopping(false), droppedBytes(0), work_(io), acceptor(io) {
+
+		// create socket
+		std::remove(socketPath.c_str());
+		Protocol::endpoint endpoint(socketPath);
+		acceptor.open(endpoint.protocol());
+		acceptor.bind(endpoint);
+		acceptor.listen();
+		setAsynchronousAccept();
+
+		// set up threads for io service and serial port writes
+		thread_ = boost::thread([this]()->void{
+			io.run();
+		});
+		writeThread = boost::thread([this]()->void{
+			writeMessages();
+		});
+
+		// share received chunks with clients
+		receiveHandlerId = port.addReceiveHandler([this](const Byte* data, std::size_t size)->void{
+			Chunk chunk(new std::vector<Byte>(data, data+size));
+			io.post([this, chunk]()->void{
+				broadcast(chunk);
+			});
+		});
+}
+
+template <class Type, class Config>
+SerialBasicDaemon<Type, Config>::~SerialBasicDaemon() {
+	port.removeReceiveHandler(receiveHandlerId);
+	io.stop();
+	thread_.join();
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(mutex);
+		stopping = true;
+	}
+	writeCondition.notify_all();
+	writeThread.join();
+	boost::system::error_code ignored;
+	acceptor.close(ignored);
+	for (auto client = clients.begin(); client != clients.end(); client++)
+		(*client)->socket.close(ignored);
+
+	// the clients' sockets must be destroyed before the io service, which is declared after them
+	pausedClients.clear();
+	clients.clear();
+	std::remove(socketPath.c_str());
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicDaemon<Type, Config>::getClientCount() {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	return clients.size();
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicDaemon<Type, Config>::getDroppedBytes() {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	return droppedBytes;
+}
+
+template <class Type, class Config>
+boost::system::error_code& SerialBasicDaemon<Type, Config>::getErrorCode() {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	return errorCode;
+}
+
+template <class Type, class Config>
+void SerialBasicDaemon<Type, Config>::setAsynchronousAccept() {
+	ClientPointer client(new Client(io));
+	acceptor.async_accept(client->socket, [this, client](const boost::system::error_code& error)->void{
+		if (error == boost::asio::error::operation_aborted)
+			return;
+		if (!error) {
+			{
+				boost::unique_lock<boost::mutex> scoped_lock(mutex);
+				clients.insert(client);
+			}
+			setAsynchronousReadSize(client);
+		}
+		setAsynchronousAccept();
+	});
+}
+
+template <class Type, class Config>
+void SerialBasicDaemon<Type, Config>::setAsynchronousReadSize(ClientPointer client) {
+	boost::asio::async_read(client->socket, boost::asio::buffer(&client->messageSize, sizeof(uint32_t)),
+		[this, client](const boost::system::error_code& error, std::size_t)->void{
+		if (error || client->messageSize == 0 || client->messageSize > MAX_MESSAGE_SIZE ||
+			client->messageSize%sizeof(Type) != 0) {
+			disconnect(client);
+			return;
+		}
+		client->message.resize(client->messageSize);
+		setAsynchronousReadMessage(client);
+	});
+}
+
+template <class Type, class Config>
+void SerialBasicDaemon<Type, Config>::setAsynchronousReadMessage(ClientPointer client) {
+	boost::asio::async_read(client->socket, boost::asio::buffer(client->message),
+		[this, client](const boost::system::error_code& error, std::size_t)->void{
+		if (error) {
+			disconnect(client);
+			return;
+		}
+		bool paused;
+		{
+			boost::unique_lock<boost::mutex> scoped_lock(mutex);
+			writeQueueBytes += client->message.size();
+			writeQueue.push_back(std::vector<Byte>());
+			writeQueue.back().swap(client->message);
+
+			// the client's next message is read once the serial port caught up
+			paused = writeQueueBytes > writeQueueLimit;
+			if (paused)
+				pausedClients.push_back(client);
+		}
+		writeCondition.notify_one();
+		if (paused == false)
+			setAsynchronousReadSize(client);
+	});
+}
+
+template <class Type, class Config>
+void SerialBasicDaemon<Type, Config>::setAsynchronousWrite(ClientPointer client) {
+	client->writing = true;
+	boost::asio::async_write(client->socket, boost::asio::buffer(*client->queue.front()),
+		[this, client](const boost::system::error_code& error, std::size_t)->void{
+		if (error) {
+			disconnect(client);
+			return;
+		}
+		client->queuedBytes -= client->queue.front()->size();
+		client->queue.pop_front();
+		if (client->queue.empty())
+			client->writing = false;
+		else
+			setAsynchronousWrite(client);
+	});
+}
+
+template <class Type, class Config>
+void SerialBasicDaemon<Type, Config>::broadcast(Chunk chunk) {
+	std::vector<ClientPointer> slowClients;
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(mutex);
+		for (auto iterator = clients.begin(); iterator != clients.end(); iterator++) {
+			const ClientPointer& client = *iterator;
+			if (client->queuedBytes+chunk->size() > clientQueueLimit) {
+				if (slowClientPolicy == DROP_DATA)
+					droppedBytes += chunk->size();
+				else
+					slowClients.push_back(client);
+				continue;
+			}
+			client->queue.push_back(chunk);
+			client->queuedBytes += chunk->size();
+			if (client->writing == false)
+				setAsynchronousWrite(client);
+		}
+	}
+	for (auto client = slowClients.begin(); client != slowClients.end(); client++)
+		disconnect(*client);
+}
+
+template <class Type, class Config>
+void SerialBasicDaemon<Type, Config>::disconnect(ClientPointer client) {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	boost::system::error_code ignored;
+	client->socket.close(ignored);
+	clients.erase(client);
+}
+
+template <class Type, class Config>
+void SerialBasicDaemon<Type, Config>::writeMessages() {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	while (true) {
+		while (writeQueue.empty() && stopping == false)
+			writeCondition.wait(scoped_lock);
+		if (stopping)
+			return;
+		std::vector<Byte> message;
+		message.swap(writeQueue.front());
+		writeQueue.pop_front();
+		scoped_lock.unlock();
+		boost::system::error_code error;
+		try {
+			port.write((const Type*)message.data(), message.size()/sizeof(Type));
+		} catch (boost::system::system_error& e) {
+			error = e.code();
+		}
+		scoped_lock.lock();
+		if (error)
+			errorCode = error;
+		writeQueueBytes -= message.size();
+		if (writeQueueBytes <= writeQueueLimit && pausedClients.empty() == false) {
+			std::vector<ClientPointer> resumedClients;
+			resumedClients.swap(pausedClients);
+			io.post([this, resumedClients]()->void{
+				for (std::size_t i = 0; i < resumedClients.size(); i++)
+					setAsynchronousReadSize(resumedClients[i]);
+			});
+		}
+	}
+}
+
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,307 @@
+#ifndef SERIAL_BASIC_DISPATCHER_H_
+#define SERIAL_BASIC_DISPATCHER_H_
+
+#include "SerialBasic.h"
+#include <deque>
+#include <vector>
+#include <chrono>
+
+/**
+ * @file SerialBasicDispatcher.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Key = uint32_t> class SerialBasicDispatcher;
+
+/**
+ * \brief Handles items read from SerialBasic objects on a pool of worker threads, in order for each key
+ *
+ * Each dispatched item is mapped to a key (e.g. a device ID or message type) by the key function. Items with the same
+ * key are handled one at a time in the order they were dispatched, whereas items with different keys are handled in
+ * parallel. Keys with pending items are scheduled on the workers' queues, and a worker whose queue is empty steals
+ * keys from the other workers, thus heavy keys spread over all cores.
+ */
+template <class Type, class Key>
+class SerialBasicDispatcher {
+public:
+	typedef std::function<Key(const Type&)> KeyFunction;
+	typedef std::function<void(const Type&)> Handler;
+
+	/**
+	 * \brief Statistics of a SerialBasicDispatcher object
+	 */
+	struct Statistics {
+		uint64_t handledItems;				/**< The amount of items handled */
+		double averageQueueLatency;			/**< The average time in microseconds from dispatch to handling */
+		uint64_t maxQueueLatency;			/**< The largest time in microseconds from dispatch to handling */
+		std::vector<double> utilization;	/**< The fraction of time each worker spent handling items */
+	};
+
+	/**
+	 * \brief Start the worker threads
+	 *
+	 * @param workerCount The amount of worker threads. 0 selects the amount of hardware threads.
+	 * @param keyFunction Maps an item to its key.
+	 * @param handler Handles an item. Called concurrently for items with different keys.
+	 */
+	SerialBasicDispatcher(std::size_t workerCount, KeyFunction keyFunction, Handler handler);
+
+	/**
+	 * \brief Wait for every dispatched item to be handled, then stop the worker threads
+	 */
+	~SerialBasicDispatcher();
+
+	/**
+	 * \brief Dispatch an item to the workers (non-blocking)
+	 *
+	 * @param item The item.
+	 */
+	void dispatch(const Type& item);
+
+	/**
+	 * \brief Read every available item from a SerialBasic object and dispatch it (non-blocking)
+	 *
+	 * @param port The SerialBasic object.
+	 * @return The amount of items dispatched.
+	 */
+	template <class Config>
+	std::size_t dispatch(SerialBasic<Type, Config>& port);
+
+	/**
+	 * \brief Get the statistics of the SerialBasicDispatcher object
+	 *
+	 * @return The statistics.
+	 */
+	Statistics getStatistics();
+private:
+	typedef std::chrono::steady_clock Clock;
+	struct Entry {
+		Type item;
+		Clock::time_point dispatchTime;
+	};
+	struct KeyQueue {
+		std::deque<Entry> entries;
+		bool scheduled;
+		KeyQueue() : scheduled(false) {}
+	};
+	typedef typename std::map<Key, KeyQueue>::iterator Task;
+	struct Worker {
+		boost::mutex mutex;
+		std::deque<Task> tasks;
+		Clock::duration busyTime;
+		boost::thread thread_;
+		Worker() : busyTime(Clock::duration::zero()) {}
+	};
+	const static std::size_t BATCH_SIZE = 16;
+	const static std::size_t READ_SIZE = 64;
+	KeyFunction keyFunction;
+	Handler handler;
+	boost::mutex keyMutex;
+	std::map<Key, KeyQueue> keyQueues;
+	boost::mutex idleMutex;
+	boost::condition_variable idleCondition;
+	std::size_t pendingTasks;
+	bool stopping;
+	std::size_t nextWorker;
+	boost::mutex statisticsMutex;
+	uint64_t handledItems;
+	uint64_t totalQueueLatency;
+	uint64_t maxQueueLatency;
+	Clock::time_point startTime;
+	std::vector<std::unique_ptr<Worker> > workers;
+	void schedule(std::size_t workerIndex, Task task);
+	bool take(std::size_t workerIndex, Task& task);
+	void work(std::size_t workerIndex);
+};
+
+template <class Type, class Key>
+SerialBasicDispatcher<Type, Key>::SerialBasicDispatcher(std::size_t workerCount, KeyFunction keyFunction,
+	Handler handler) : keyFunction(keyFunction), handler(handler), pendingTasks(0), stopping(false), nextWorker(0),
+	handledItems(0), totalQueueLatency(0), maxQueueLatency(0), startTime(Clock::now()) {
+		if (workerCount == 0)
+			workerCount = boost::thread::hardware_concurrency();
+		if (workerCount == 0)
+			workerCount = 1;
+		for (std::size_t i = 0; i < workerCount; i++)
+			workers.push_back(std::unique_ptr<Worker>(new Worker()));
+		for (std::size_t i = 0; i < workerCount; i++)
+			workers[i]->thread_ = boost::thread([this, i]()->void{
+				work(i);
+			});
+}
+
+template <class Type, class Key>
+SerialBasicDispatcher<Type, Key>::~SerialBasicDispatcher() {
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(idleMutex);
+		stopping = true;
+	}
+	idleCondition.notify_all();
+	for (std::size_t i = 0; i < workers.size(); i++)
+		workers[i]->thread_.join();
+}
+
+template <class Type, class Key>
+void SerialBasicDispatcher<Type, Key>::dispatch(const Type& item) {
+	Key key = keyFunction(item);
+	Entry entry = {item, Clock::now()};
+	Task task;
+	std::size_t workerIndex;
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(keyMutex);
+		task = keyQueues.insert(std::make_pair(key, KeyQueue())).first;
+		task->second.entries.push_back(entry);
+		if (task->second.scheduled)
+			return;
+		task->second.scheduled = true;
+		workerIndex = nextWorker++%workers.size();
+	}
+	schedule(workerIndex, task);
+}
+
+template <class Type, class Key>
+template <class Config>
+std::size_t SerialBasicDispatcher<Type, Key>::dispatch(SerialBasic<Type, Config>& port) {
+	Type items[READ_SIZE];
+	std::size_t dispatchedItems = 0;
+	std::size_t readItems;
+	do {
+		readItems = port.read(items, READ_SIZE);
+		for (std::size_t i = 0; i < readItems; i++)
+			dispatch(items[i]);
+		dispatchedItems += readItems;
+	} while (readItems == READ_SIZE);
+	return dispatchedItems;
+}
+
+template <class Type, class Key>
+typename SerialBasicDispatcher<Type, Key>::Statistics SerialBasicDispatcher<Type, Key>::getStatistics() {
+	Statistics statistics;
+	double elapsedTime = (double)(Clock::now()-startTime).count();
+	boost::unique_lock<boost::mutex> scoped_lock(statisticsMutex);
+	statistics.handledItems = handledItems;
+	statistics.averageQueueLatency = (handledItems == 0) ? 0.0 : (double)totalQueueLatency/handledItems;
+	statistics.maxQueueLatency = maxQueueLatency;
+	for (std::size_t i = 0; i < workers.size(); i++)
+		statistics.utilization.push_back((elapsedTime == 0.0) ? 0.0 : workers[i]->busyTime.count()/elapsedTime);
+	return statistics;
+}
+
+template <class Type, class Key>
+void SerialBasicDispatcher<Type, Key>::schedule(std::size_t workerIndex, Task task) {
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(workers[workerIndex]->mutex);
+		workers[workerIndex]->tasks.push_back(task);
+	}
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(idleMutex);
+		pendingTasks++;
+	}
+	idleCondition.notify_one();
+}
+
+template <class Type, class Key>
+bool SerialBasicDispatcher<Type, Key>::take(std::size_t workerIndex, Task& task) {
+
+	// take from the front of the worker's own queue first, otherwise steal from the back of another worker's queue
+	for (std::size_t i = 0; i < workers.size(); i++) {
+		Worker& worker = *workers[(workerIndex+i)%workers.size()];
+		boost::unique_lock<boost::mutex> scoped_lock(worker.mutex);
+		if (worker.tasks.empty())
+			continue;
+		if (i == 0) {
+			task = worker.tasks.front();
+			worker.tasks.pop_front();
+		} else {
+			task = worker.tasks.back();
+			worker.tasks.pop_back();
+		}
+		return true;
+	}
+	return false;
+}
+
+template <class Type, class Key>
+void SerialBasicDispatcher<Type, Key>::work(std::size_t workerIndex) {
+	while (true) {
+
+		// wait for a task
+		{
+			boost::unique_lock<boost::mutex> scoped_lock(idleMutex);
+			while (pendingTasks == 0 && stopping == false)
+				idleCondition.wait(scoped_lock);
+			if (pendingTasks == 0)
+				return;
+			pendingTasks--;
+		}
+		Task task;
+		while (take(workerIndex, task) == false)
+			boost::this_thread::yield();
+
+		// handle a batch of the key's items, in order. The key is only removed once its last item is handled, so another
+		// worker cannot handle a newer item of the same key concurrently
+		Clock::time_point busyStartTime = Clock::now();
+		bool reschedule = true;
+		for (std::size_t i = 0; i < BATCH_SIZE && reschedule; i++) {
+			Entry entry;
+			{
+				boost::unique_lock<boost::mutex> scoped_lock(keyMutex);
+				if (task->second.entries.empty()) {
+					keyQueues.erase(task);
+					reschedule = false;
+					break;
+				}
+				entry = task->second.entries.front();
+				task->second.entries.pop_front();
+			}
+			uint64_t queueLatency = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+				Clock::now()-entry.dispatchTime).count();
+			handler(entry.item);
+			boost::unique_lock<boost::mutex> scoped_lock(statisticsMutex);
+			handledItems++;
+			totalQueueLatency += queueLatency;
+			if (queueLatency > maxQueueLatency)
+				maxQueueLatency = queueLatency;
+		}
+		if (reschedule) {
+			boost::unique_lock<boost::mutex> scoped_lock(keyMutex);
+			if (task->second.entries.empty()) {
+				keyQueues.erase(task);
+				reschedule = false;
+			}
+		}
+		{
+			boost::unique_lock<boost::mutex> scoped_lock(statisticsMutex);
+			workers[workerIndex]->busyTime += Clock::now()-busyStartTime;
+		}
+
+		// a key with more items goes to the back of the queue, so other keys are not starved
+		if (reschedule)
+			schedule(workerIndex, task);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,525 @@
+#ifndef SERIAL_BASIC_FILE_TRANSFER_H_
+#define SERIAL_BASIC_FILE_TRANSFER_H_
+
+#include "SerialBasic.h"
+#include "SerialBasicMessages.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+
+/**
+ * @file SerialBasicFileTransfer.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+/**
+ * \brief The packets of the bulk file transfer protocol of SerialBasicFileSender and SerialBasicFileReceiver
+ *
+ * Every packet is a message of SerialBasicMessages with a CRC, thus every block is checked by its own CRC. Fields are
+ * little endian.
+ *
+ *	- OFFER (sender to receiver): type, transfer ID (4 bytes), file size (8 bytes), block size (4 bytes)
+ *	- DATA (sender to receiver): type, transfer ID, block index (4 bytes), the block's data
+ *	- STATUS (receiver to sender): type, transfer ID, the amount of blocks received in order (4 bytes), and a bitmap
+ *	  (8 bytes) of which of the following 64 blocks were received
+ *	- CLOSE (sender to receiver): type, transfer ID, once the sender learned that the whole file was received
+ */
+struct SerialBasicFileTransfer {
+	enum PacketType {
+		OFFER = 1,
+		DATA = 2,
+		STATUS = 3,
+		CLOSE = 4
+	};
+	const static std::size_t OFFER_SIZE = 17;
+	const static std::size_t DATA_HEADER_SIZE = 9;
+	const static std::size_t STATUS_SIZE = 17;
+	const static std::size_t CLOSE_SIZE = 5;
+	const static std::size_t STATUS_BITMAP_SIZE = 64;
+	static void put(uint8_t* data, uint64_t value, std::size_t size) {
+		for (std::size_t i = 0; i < size; i++)
+			data[i] = (uint8_t)(value >> (8*i));
+	}
+	static uint64_t get(const uint8_t* data, std::size_t size) {
+		uint64_t value = 0;
+		for (std::size_t i = 0; i < size; i++)
+			value |= ((uint64_t)data[i]) << (8*i);
+		return value;
+	}
+};
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicFileSender;
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicFileReceiver;
+
+/**
+ * \brief Sends a file to a SerialBasicFileReceiver over a SerialBasic object, with a sliding window
+ *
+ * The file is memory-mapped and split in blocks. Up to windowSize blocks are sent without waiting for the receiver,
+ * which periodically reports which blocks it received, thus the link is kept busy. Only the blocks that are not
+ * reported as received within a retransmission timeout are sent again. If the receiver stops reporting (e.g. the link
+ * was lost), the transfer is offered again until the receiver answers, and resumes from the blocks the receiver
+ * already has, which also works across restarts of either side.
+ *
+ * While a transfer is in progress, the SerialBasic object should not be read by other means.
+ */
+template <class Type, class Config>
+class SerialBasicFileSender {
+public:
+
+	/**
+	 * \brief Statistics of the last transfer
+	 */
+	struct Statistics {
+		uint64_t fileSize;				/**< The size of the file in bytes */
+		uint64_t sentBlocks;			/**< The amount of blocks sent, including retransmissions */
+		uint64_t retransmittedBlocks;	/**< The amount of blocks sent again */
+		double elapsedTime;				/**< The duration of the transfer in seconds */
+		double throughput;				/**< The file's size divided by the duration, in bytes per second */
+		double efficiency;				/**< The throughput relative to the raw rate of the link at 10 bits per byte */
+	};
+
+	/**
+	 * \brief Create a sender
+	 *
+	 * @param port The SerialBasic object. It must outlive the SerialBasicFileSender object.
+	 * @param blockSize The size of a block in bytes. It must not exceed the receiver's maximum block size.
+	 * @param windowSize The maximum amount of blocks sent ahead of the first block not received, at most 65.
+	 */
+	SerialBasicFileSender(SerialBasic<Type, Config>& port, std::size_t blockSize = 512, std::size_t windowSize = 32);
+
+	/**
+	 * \brief Send a file (blocking)
+	 *
+	 * @param path The path of the file.
+	 * @param timeout The maximum time in milliseconds without progress, e.g. while the link is lost.
+	 * @return True if the receiver received the whole file, false if the timeout expired.
+	 * @throw boost::interprocess::interprocess_exception Thrown if the file could not be mapped.
+	 */
+	bool send(const std::string& path, uint32_t timeout = 10000);
+
+	/**
+	 * \brief Get the statistics of the last transfer
+	 *
+	 * @return The statistics.
+	 */
+	Statistics getStatistics();
+private:
+	typedef std::chrono::steady_clock Clock;
+	SerialBasic<Type, Config>& port;
+	SerialBasicMessages<Type, Config> messages;
+	std::size_t blockSize;
+	std::size_t windowSize;
+	Statistics statistics;
+	void write(const uint8_t* packet, std::size_t size);
+};
+
+/**
+ * \brief Receives a file from a SerialBasicFileSender over a SerialBasic object
+ *
+ * Blocks are written straight into the destination file, which is memory-mapped. The blocks received so far are
+ * recorded in a memory-mapped side file named after the destination with the suffix .partial, so that an interrupted
+ * transfer of the same file resumes where it stopped, even after a restart, unless the destination file was removed or
+ * resized meanwhile, in which case the transfer starts over. The side file is removed once the file is complete.
+ *
+ * While a transfer is in progress, the SerialBasic object should not be read by other means.
+ */
+template <class Type, class Config>
+class SerialBasicFileReceiver {
+public:
+
+	/**
+	 * \brief Create a receiver
+	 *
+	 * @param port The SerialBasic object. It must outlive the SerialBasicFileReceiver object.
+	 * @param maxBlockSize The maximum size of a block in bytes. Offers of larger blocks are ignored.
+	 */
+	SerialBasicFileReceiver(SerialBasic<Type, Config>& port, std::size_t maxBlockSize = 4096);
+
+	/**
+	 * \brief Receive a file (blocking)
+	 *
+	 * Once the whole file is received, the receiver keeps answering the sender, whose last status may have been lost,
+	 * until the sender closes the transfer, or until the timeout expires without a packet.
+	 *
+	 * @param path The path of the destination file.
+	 * @param timeout The maximum time in milliseconds without receiving a packet.
+	 * @return True if the whole file was received, false if the timeout expired before.
+	 * @throw boost::interprocess::interprocess_exception Thrown if the destination file could not be mapped.
+	 */
+	bool receive(const std::string& path, uint32_t timeout = 10000);
+private:
+	typedef std::chrono::steady_clock Clock;
+	const static uint32_t MAGIC = 0x53424654;
+	const static std::size_t ACK_INTERVAL = 4;
+	const static std::size_t ACK_DELAY = 20;
+	struct PartialHeader {
+		uint32_t magic;
+		uint32_t transferId;
+		uint64_t fileSize;
+		uint64_t blockSize;
+	};
+	SerialBasic<Type, Config>& port;
+	SerialBasicMessages<Type, Config> messages;
+	std::size_t maxBlockSize;
+	boost::interprocess::mapped_region destination;
+	boost::interprocess::mapped_region partial;
+	PartialHeader* partialHeader;
+	uint8_t* receivedBlocks;
+	uint64_t blockCount;
+	uint64_t completeBlocks;
+	void open(const std::string& path, uint32_t transferId, uint64_t fileSize, uint64_t blockSize);
+	void close(const std::string& path);
+	void sendStatus();
+	bool isReceived(uint64_t block);
+	static void createFile(const std::string& path, uint64_t size);
+};
+
+template <class Type, class Config>
+const std::size_t SerialBasicFileReceiver<Type, Config>::ACK_DELAY;
+
+template <class Type, class Config>
+SerialBasicFileSender<Type, Config>::SerialBasicFileSender(SerialBasic<Type, Config>& port, std::size_t blockSize,
+	std::size_t windowSize) : port(port), messages(port, SerialBasicFileTransfer::DATA_HEADER_SIZE+blockSize, true),
+	blockSize(blockSize), windowSize((windowSize > SerialBasicFileTransfer::STATUS_BITMAP_SIZE+1) ?
+		SerialBasicFileTransfer::STATUS_BITMAP_SIZE+1 : windowSize) {
+	std::memset(&statistics, 0, sizeof(Statistics));
+}
+
+template <class Type, class Config>
+bool SerialBasicFileSender<Type, Config>::send(const std::string& path, uint32_t timeout) {
+	std::memset(&statistics, 0, sizeof(Statistics));
+	Clock::time_point startTime = Clock::now();
+
+	// an empty file cannot be mapped
+	uint64_t fileSize = 0;
+	{
+		std::ifstream file(path.c_str(), std::ios_base::binary|std::ios_base::ate);
+		if (file.good())
+			fileSize = (uint64_t)file.tellg();
+	}
+	boost::interprocess::mapped_region region;
+	const uint8_t* data = NULL;
+	if (fileSize != 0) {
+		boost::interprocess::file_mapping file(path.c_str(), boost::interprocess::read_only);
+		boost::interprocess::mapped_region(file, boost::interprocess::read_only).swap(region);
+		data = (const uint8_t*)region.get_address();
+	}
+	uint64_t blockCount = (fileSize+blockSize-1)/blockSize;
+
+	// the transfer is identified by the file's content, so that only an identical file is resumed
+	uint32_t transferId = 2166136261u;
+	for (uint64_t i = 0; i < fileSize; i++)
+		transferId = (transferId^data[i])*16777619u;
+	transferId ^= (uint32_t)fileSize;
+
+	// the retransmission timeout allows a whole window to be sent and reported at the link's rate
+	uint32_t baudRate = port.getBaudRate();
+	Clock::duration retransmitTimeout = std::chrono::milliseconds(100+
+		(uint64_t)windowSize*(blockSize+SerialBasicFileTransfer::DATA_HEADER_SIZE+8)*10*1000/(baudRate ? baudRate : 1));
+	Clock::duration linkTimeout = retransmitTimeout*4;
+	std::vector<uint8_t> received((std::size_t)blockCount, 0);
+	std::vector<Clock::time_point> sentTime((std::size_t)blockCount);
+	std::vector<uint8_t> sent((std::size_t)blockCount, 0);
+	std::vector<uint8_t> packet(SerialBasicFileTransfer::DATA_HEADER_SIZE+blockSize);
+	uint64_t base = 0;
+	bool accepted = false;
+	Clock::time_point lastProgress = Clock::now();
+	Clock::time_point lastStatus = Clock::now();
+	Clock::time_point lastOffer = Clock::now()-retransmitTimeout;
+	while (accepted == false || base < blockCount) {
+		Clock::time_point now = Clock::now();
+		bool busy = false;
+
+		// offer the transfer until the receiver answers, which is also how a lost link is resumed
+		if (accepted && now-lastStatus > linkTimeout)
+			accepted = false;
+		if (accepted == false && now-lastOffer >= retransmitTimeout) {
+			packet[0] = SerialBasicFileTransfer::OFFER;
+			SerialBasicFileTransfer::put(&packet[1], transferId, 4);
+			SerialBasicFileTransfer::put(&packet[5], fileSize, 8);
+			SerialBasicFileTransfer::put(&packet[13], blockSize, 4);
+			write(packet.data(), SerialBasicFileTransfer::OFFER_SIZE);
+			lastOffer = now;
+		}
+
+		// send the blocks of the window that were not sent yet or timed out
+		for (uint64_t block = base; accepted && block < blockCount && block < base+windowSize; block++) {
+			if (received[block] || (sent[block] && now-sentTime[block] < retransmitTimeout))
+				continue;
+			std::size_t size = (block == blockCount-1) ? (std::size_t)(fileSize-block*blockSize) : blockSize;
+			packet[0] = SerialBasicFileTransfer::DATA;
+			SerialBasicFileTransfer::put(&packet[1], transferId, 4);
+			SerialBasicFileTransfer::put(&packet[5], block, 4);
+			std::memcpy(&packet[SerialBasicFileTransfer::DATA_HEADER_SIZE], data+block*blockSize, size);
+			write(packet.data(), SerialBasicFileTransfer::DATA_HEADER_SIZE+size);
+			statistics.sentBlocks++;
+			if (sent[block])
+				statistics.retransmittedBlocks++;
+			sent[block] = 1;
+			sentTime[block] = Clock::now();
+			busy = true;
+		}
+
+		// apply the receiver's reports
+		const uint8_t* message;
+		std::size_t size;
+		while (messages.receive(message, size)) {
+			if (size != SerialBasicFileTransfer::STATUS_SIZE || message[0] != SerialBasicFileTransfer::STATUS ||
+				SerialBasicFileTransfer::get(&message[1], 4) != transferId)
+				continue;
+			uint64_t statusBase = SerialBasicFileTransfer::get(&message[5], 4);
+			uint64_t bitmap = SerialBasicFileTransfer::get(&message[9], 8);
+			bool progress = accepted == false;
+
+			// reports arrive in order, thus a receiver that reports fewer blocks than before lost them (e.g. its
+			// destination file was removed), and every block it does not report is sent again
+			if (statusBase < base) {
+				for (uint64_t block = statusBase; block < blockCount; block++) {
+					received[block] = 0;
+					sent[block] = 0;
+				}
+				base = statusBase;
+			}
+			for (uint64_t block = base; block < statusBase && block < blockCount; block++) {
+				progress |= received[block] == 0;
+				received[block] = 1;
+			}
+			for (uint64_t bit = 0; bit < SerialBasicFileTransfer::STATUS_BITMAP_SIZE; bit++) {
+				if (((bitmap >> bit) & 1) && statusBase+1+bit < blockCount) {
+					progress |= received[statusBase+1+bit] == 0;
+					received[statusBase+1+bit] = 1;
+				}
+			}
+			while (base < blockCount && received[base])
+				base++;
+			if (progress)
+				lastProgress = Clock::now();
+			accepted = true;
+			lastStatus = Clock::now();
+			busy = true;
+		}
+		if (Clock::now()-lastProgress > std::chrono::milliseconds(timeout))
+			return false;
+		if (busy == false)
+			port.wait(1, port.available());
+	}
+
+	// the receiver answers until the transfer is closed, in case a status was lost
+	packet[0] = SerialBasicFileTransfer::CLOSE;
+	SerialBasicFileTransfer::put(&packet[1], transferId, 4);
+	write(packet.data(), SerialBasicFileTransfer::CLOSE_SIZE);
+	statistics.fileSize = fileSize;
+	statistics.elapsedTime = std::chrono::duration<double>(Clock::now()-startTime).count();
+	statistics.throughput = (statistics.elapsedTime > 0.0) ? fileSize/statistics.elapsedTime : 0.0;
+	statistics.efficiency = statistics.throughput*10.0/(baudRate ? baudRate : 1);
+	return true;
+}
+
+template <class Type, class Config>
+typename SerialBasicFileSender<Type, Config>::Statistics SerialBasicFileSender<Type, Config>::getStatistics() {
+	return statistics;
+}
+
+template <class Type, class Config>
+void SerialBasicFileSender<Type, Config>::write(const uint8_t* packet, std::size_t size) {
+
+	// a failed write is handled like a lost packet
+	try {
+		messages.send(packet, size);
+	} catch (boost::system::system_error&) {
+	}
+}
+
+template <class Type, class Config>
+SerialBasicFileReceiver<Type, Config>::SerialBasicFileReceiver(SerialBasic<Type, Config>& port,
+	std::size_t maxBlockSize) : port(port), messages(port, SerialBasicFileTransfer::DATA_HEADER_SIZE+maxBlockSize, true),
+	maxBlockSize(maxBlockSize), partialHeader(NULL), receivedBlocks(NULL), blockCount(0), completeBlocks(0) {
+}
+
+template <class Type, class Config>
+bool SerialBasicFileReceiver<Type, Config>::receive(const std::string& path, uint32_t timeout) {
+	Clock::time_point lastActivity = Clock::now();
+	Clock::time_point lastStatus = Clock::now();
+	std::size_t unreportedBlocks = 0;
+	while (true) {
+		const uint8_t* message;
+		std::size_t size;
+		while (messages.receive(message, size)) {
+			if (size < 5)
+				continue;
+			uint32_t transferId = (uint32_t)SerialBasicFileTransfer::get(&message[1], 4);
+			if (message[0] == SerialBasicFileTransfer::OFFER && size == SerialBasicFileTransfer::OFFER_SIZE) {
+				uint64_t fileSize = SerialBasicFileTransfer::get(&message[5], 8);
+				uint64_t blockSize = SerialBasicFileTransfer::get(&message[13], 4);
+
+				// blocks larger than the maximum could not be received, and the sender must not size the side file
+				if (blockSize > maxBlockSize || (blockSize == 0 && fileSize != 0))
+					continue;
+				if (partialHeader == NULL || partialHeader->transferId != transferId)
+					open(path, transferId, fileSize, blockSize);
+				unreportedBlocks++;
+			} else if (message[0] == SerialBasicFileTransfer::DATA && partialHeader != NULL &&
+				partialHeader->transferId == transferId && size >= SerialBasicFileTransfer::DATA_HEADER_SIZE) {
+				uint64_t block = SerialBasicFileTransfer::get(&message[5], 4);
+				std::size_t blockSize = (std::size_t)partialHeader->blockSize;
+				std::size_t expectedSize = (block == blockCount-1) ?
+					(std::size_t)(partialHeader->fileSize-block*blockSize) :
+					blockSize;
+				if (block < blockCount && size-SerialBasicFileTransfer::DATA_HEADER_SIZE == expectedSize &&
+					isReceived(block) == false) {
+					std::memcpy((uint8_t*)destination.get_address()+block*blockSize,
+						&message[SerialBasicFileTransfer::DATA_HEADER_SIZE], expectedSize);
+					receivedBlocks[block/8] |= (uint8_t)(1 << (block%8));
+					while (completeBlocks < blockCount && isReceived(completeBlocks))
+						completeBlocks++;
+				}
+				unreportedBlocks++;
+			} else if (message[0] == SerialBasicFileTransfer::CLOSE && partialHeader != NULL &&
+				partialHeader->transferId == transferId && completeBlocks == blockCount) {
+				close(path);
+				return true;
+			} else {
+				continue;
+			}
+			lastActivity = Clock::now();
+			if (unreportedBlocks >= ACK_INTERVAL || completeBlocks == blockCount) {
+				sendStatus();
+				lastStatus = Clock::now();
+				unreportedBlocks = 0;
+			}
+		}
+		Clock::time_point now = Clock::now();
+		if (unreportedBlocks != 0 && now-lastStatus >= std::chrono::milliseconds(ACK_DELAY)) {
+			sendStatus();
+			lastStatus = now;
+			unreportedBlocks = 0;
+		}
+
+		// once complete, the receiver answers the sender until the transfer is closed, or until the sender is gone
+		if (now-lastActivity >= std::chrono::milliseconds(timeout)) {
+			if (partialHeader == NULL || completeBlocks != blockCount)
+				return false;
+			close(path);
+			return true;
+		}
+		port.wait(1, port.available());
+	}
+}
+
+template <class Type, class Config>
+void SerialBasicFileReceiver<Type, Config>::open(const std::string& path, uint32_t transferId, uint64_t fileSize,
+	uint64_t blockSize) {
+	blockCount = (blockSize == 0) ? 0 : (fileSize+blockSize-1)/blockSize;
+	std::string partialPath = path+".partial";
+	std::size_t partialSize = sizeof(PartialHeader)+(std::size_t)(blockCount+7)/8;
+
+	// resume if the side file records the same transfer and the destination file is still there, otherwise start over
+	bool resume = false;
+	{
+		std::ifstream file(partialPath.c_str(), std::ios_base::binary);
+		PartialHeader header;
+		if (file.read((char*)&header, sizeof(PartialHeader)).good())
+			resume = header.magic == MAGIC && header.transferId == transferId && header.fileSize == fileSize &&
+				header.blockSize == blockSize;
+	}
+	if (resume) {
+		std::ifstream file(path.c_str(), std::ios_base::binary|std::ios_base::ate);
+		resume = file.good() && (uint64_t)file.tellg() == fileSize;
+	}
+	if (resume == false) {
+		createFile(partialPath, partialSize);
+		createFile(path, fileSize);
+	}
+	boost::interprocess::file_mapping partialFile(partialPath.c_str(), boost::interprocess::read_write);
+	boost::interprocess::mapped_region(partialFile, boost::interprocess::read_write).swap(partial);
+	partialHeader = (PartialHeader*)partial.get_address();
+	receivedBlocks = (uint8_t*)(partialHeader+1);
+	if (resume == false) {
+		std::memset(partial.get_address(), 0, partialSize);
+		partialHeader->transferId = transferId;
+		partialHeader->fileSize = fileSize;
+		partialHeader->blockSize = blockSize;
+		partialHeader->magic = MAGIC;
+	}
+	boost::interprocess::mapped_region().swap(destination);
+	if (fileSize != 0) {
+		boost::interprocess::file_mapping destinationFile(path.c_str(), boost::interprocess::read_write);
+		boost::interprocess::mapped_region(destinationFile, boost::interprocess::read_write).swap(destination);
+	}
+	completeBlocks = 0;
+	while (completeBlocks < blockCount && isReceived(completeBlocks))
+		completeBlocks++;
+}
+
+template <class Type, class Config>
+void SerialBasicFileReceiver<Type, Config>::close(const std::string& path) {
+	if (destination.get_size() != 0)
+		destination.flush();
+	boost::interprocess::mapped_region().swap(destination);
+	boost::interprocess::mapped_region().swap(partial);
+	partialHeader = NULL;
+	receivedBlocks = NULL;
+	boost::interprocess::file_mapping::remove((path+".partial").c_str());
+}
+
+template <class Type, class Config>
+void SerialBasicFileReceiver<Type, Config>::sendStatus() {
+	if (partialHeader == NULL)
+		return;
+	uint64_t bitmap = 0;
+	for (uint64_t bit = 0; bit < SerialBasicFileTransfer::STATUS_BITMAP_SIZE; bit++)
+		if (completeBlocks+1+bit < blockCount && isReceived(completeBlocks+1+bit))
+			bitmap |= ((uint64_t)1) << bit;
+	uint8_t packet[SerialBasicFileTransfer::STATUS_SIZE];
+	packet[0] = SerialBasicFileTransfer::STATUS;
+	SerialBasicFileTransfer::put(&packet[1], partialHeader->transferId, 4);
+	SerialBasicFileTransfer::put(&packet[5], completeBlocks, 4);
+	SerialBasicFileTransfer::put(&packet[9], bitmap, 8);
+	try {
+		messages.send(packet, SerialBasicFileTransfer::STATUS_SIZE);
+	} catch (boost::system::system_error&) {
+	}
+}
+
+template <class Type, class Config>
+bool SerialBasicFileReceiver<Type, Config>::isReceived(uint64_t block) {
+	return (receivedBlocks[block/8] >> (block%8)) & 1;
+}
+
+template <class Type, class Config>
+void SerialBasicFileReceiver<Type, Config>::createFile(const std::string& path, uint64_t size) {
+	std::filebuf file;
+	file.open(path.c_str(), std::ios_base::out|std::ios_base::trunc|std::ios_base::binary);
+	if (size != 0) {
+		file.pubseekoff((std::streamoff)size-1, std::ios_base::beg);
+		file.sputc(0);
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,178 @@
+#ifndef SERIAL_BASIC_ITEM_VIEW_H_
+#define SERIAL_BASIC_ITEM_VIEW_H_
+
+#include "SerialBasic.h"
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<ranges>)
+#include <ranges>
+#include <iterator>
+#define SERIAL_BASIC_HAS_RANGES
+#endif
+#endif
+
+/**
+ * @file SerialBasicItemView.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+#if defined(SERIAL_BASIC_HAS_RANGES)
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicItemView;
+
+/**
+ * \brief A lazy C++20 input range over the items received by a SerialBasic object
+ *
+ * Each item is read from the SerialBasic object's buffer only once it is accessed, or once the range is checked for its
+ * end, rather than when the range is advanced past the previous item, thus range adaptors
+ * such as std::views::filter and std::views::take can replace polling loops around read() without an intermediate
+ * container, e.g.
+ *
+ *	for (auto& item : SerialBasicItemView(port) | std::views::filter(isValid) | std::views::take(10))
+ *
+ * When the SerialBasic object's buffer is empty, the range waits for items according to its wait policy, and ends
+ * otherwise. Items read by the range are removed from the SerialBasic object's buffer, including those skipped by
+ * adaptors. Since advancing does not read, std::views::take ends after the last item it takes without reading another
+ * one, although an adaptor in between may still read ahead when advanced (e.g. std::views::filter searches for its next
+ * match). Only available when compiled as C++20.
+ */
+template <class Type, class Config>
+class SerialBasicItemView : public std::ranges::view_interface<SerialBasicItemView<Type, Config> > {
+public:
+
+	/**
+	 * \brief What the range does when the SerialBasic object's buffer is empty
+	 */
+	enum WaitPolicy {
+		NON_BLOCKING,	/**< The range ends */
+		TIMEOUT,		/**< The range waits up to the timeout for an item, and ends if none is received */
+		BLOCKING		/**< The range waits until an item is received, or until the connection is lost */
+	};
+
+	/**
+	 * \brief An input iterator that reads the current item when it is dereferenced or compared with the end
+	 */
+	class Iterator {
+	public:
+		typedef std::input_iterator_tag iterator_concept;
+		typedef Type value_type;
+		typedef std::ptrdiff_t difference_type;
+		Iterator() : view(NULL) {}
+		const Type& operator*() const {
+			view->fetch();
+			return view->item;
+		}
+		Iterator& operator++() {
+			view->consume();
+			return *this;
+		}
+		void operator++(int) {
+			view->consume();
+		}
+		friend bool operator==(const Iterator& iterator, std::default_sentinel_t) {
+			return iterator.isEnded();
+		}
+	private:
+		friend class SerialBasicItemView;
+		SerialBasicItemView* view;
+		Iterator(SerialBasicItemView* view) : view(view) {}
+		bool isEnded() const {
+			view->fetch();
+			return view->ended;
+		}
+	};
+
+	/**
+	 * \brief Create a range over the items received by a SerialBasic object
+	 *
+	 * @param port The SerialBasic object. It must outlive the range.
+	 * @param waitPolicy What the range does when the SerialBasic object's buffer is empty.
+	 * @param timeout The maximum time to wait for an item in milliseconds with the TIMEOUT policy, and the interval at
+	 * which the connection is checked with the BLOCKING policy.
+	 */
+	SerialBasicItemView(SerialBasic<Type, Config>& port, WaitPolicy waitPolicy = TIMEOUT, uint32_t timeout = 1000);
+
+	/**
+	 * \brief Get an iterator to the first item, which is read once the iterator is dereferenced or compared with the end
+	 *
+	 * As with any input range, begin() should be called once.
+	 *
+	 * @return An iterator to the first item.
+	 */
+	Iterator begin();
+
+	/**
+	 * \brief Get the end of the range
+	 *
+	 * @return A sentinel, which an iterator equals once the range ended.
+	 */
+	std::default_sentinel_t end() const {
+		return std::default_sentinel;
+	}
+private:
+	friend class Iterator;
+	SerialBasic<Type, Config>* port;
+	WaitPolicy waitPolicy;
+	uint32_t timeout;
+	Type item;
+	bool fetched;
+	bool ended;
+	void fetch();
+	void consume();
+};
+
+template <class Type, class Config>
+SerialBasicItemView<Type, Config>::SerialBasicItemView(SerialBasic<Type, Config>& port, WaitPolicy waitPolicy,
+	uint32_t timeout) : port(&port), waitPolicy(waitPolicy), timeout(timeout), item(), fetched(false), ended(false) {
+}
+
+template <class Type, class Config>
+typename SerialBasicItemView<Type, Config>::Iterator SerialBasicItemView<Type, Config>::begin() {
+	return Iterator(this);
+}
+
+template <class Type, class Config>
+void SerialBasicItemView<Type, Config>::fetch() {
+	while (fetched == false && ended == false) {
+		if (port->read(&item, 1) == 1) {
+			fetched = true;
+			return;
+		}
+		if (waitPolicy == NON_BLOCKING || port->getErrorCode())
+			ended = true;
+		else if (port->wait(timeout) == 0 && waitPolicy == TIMEOUT)
+			ended = true;
+	}
+}
+
+template <class Type, class Config>
+void SerialBasicItemView<Type, Config>::consume() {
+
+	// the next item is only read once it is needed
+	fetch();
+	fetched = false;
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -0,0 +1,258 @@
+#ifndef SERIAL_BASIC_MERGER_H_
+#define SERIAL_BASIC_MERGER_H_
+
+#include "SerialBasic.h"
+#include <deque>
+#include <vector>
+#include <queue>
+
+/**
+ * @file SerialBasicMerger.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicMerger;
+
+/**
+ * \brief Merges timestamped items read from many SerialBasic objects into a single stream in timestamp order
+ *
+ * Items read from each port are buffered per port, and the ports are merged with a heap over the oldest buffered item
+ * of each port, thus emitting an item costs O(log k) for k ports. An item is emitted once its timestamp is at most the
+ * watermark, which is the larger of
+ *
+ *	- the smallest of the ports' newest timestamps, since no port can still deliver an older item in order, and
+ *	- the newest timestamp of any port minus the reorder window, so a silent port delays items by a bounded time.
+ *
+ * An item older than an item already emitted is late. Late items are emitted immediately and counted.
+ *
+ * Items of each port are expected to be mostly in timestamp order; an item older than its port's buffered items is
+ * inserted in order. A SerialBasicMerger object is intended to be used by a single thread.
+ */
+template <class Type, class Config>
+class SerialBasicMerger {
+public:
+	typedef std::function<uint64_t(const Type&)> TimestampFunction;
+
+	/**
+	 * \brief Create a merger without ports
+	 *
+	 * @param timestampFunction Gets the timestamp of an item. Any unit can be used, as long as it is the unit of
+	 * reorderWindow.
+	 * @param reorderWindow The maximum time an item is held back waiting for older items from other ports.
+	 */
+	SerialBasicMerger(TimestampFunction timestampFunction, uint64_t reorderWindow);
+
+	/**
+	 * \brief Add a port
+	 *
+	 * @param port The SerialBasic object. It must outlive the SerialBasicMerger object.
+	 * @return The index of the port, passed to the handler of merge().
+	 */
+	std::size_t add(SerialBasic<Type, Config>& port);
+
+	/**
+	 * \brief Read every available item from the ports, then emit the items that are ready in timestamp order
+	 * (non-blocking)
+	 *
+	 * The handler is called with (std::size_t index, const Type& item) for each emitted item.
+	 *
+	 * @param handler The handler.
+	 * @return The amount of items emitted.
+	 */
+	template <class Handler>
+	std::size_t merge(Handler handler);
+
+	/**
+	 * \brief Emit every buffered item in timestamp order, regardless of the watermark
+	 *
+	 * @param handler The handler, as for merge().
+	 * @return The amount of items emitted.
+	 */
+	template <class Handler>
+	std::size_t flush(Handler handler);
+
+	/**
+	 * \brief Get the current watermark
+	 *
+	 * @return The timestamp up to which buffered items are emitted.
+	 */
+	uint64_t getWatermark();
+
+	/**
+	 * \brief Get the amount of late items
+	 *
+	 * @return The amount of items that arrived older than an item already emitted.
+	 */
+	uint64_t getLateItems();
+private:
+	struct Record {
+		Type item;
+		uint64_t timestamp;
+		uint64_t sequence;
+	};
+	struct Source {
+		SerialBasic<Type, Config>* port;
+		std::deque<Record> records;
+		uint64_t newestTimestamp;
+		bool received;
+	};
+	struct Head {
+		uint64_t timestamp;
+		uint64_t sequence;
+		std::size_t index;
+		bool operator>(const Head& head) const {
+			return (timestamp != head.timestamp) ? timestamp > head.timestamp : sequence > head.sequence;
+		}
+	};
+	const static std::size_t READ_SIZE = 64;
+	TimestampFunction timestampFunction;
+	uint64_t reorderWindow;
+	std::vector<Source> sources;
+	std::priority_queue<Head, std::vector<Head>, std::greater<Head> > heads;
+	uint64_t nextSequence;
+	uint64_t newestTimestamp;
+	uint64_t emittedTimestamp;
+	bool emitted;
+	uint64_t lateItems;
+	template <class Handler>
+	std::size_t emit(Handler handler, bool all);
+	void pushHead(std::size_t index);
+};
+
+template <class Type, class Config>
+SerialBasicMerger<Type, Config>::SerialBasicMerger(TimestampFunction timestampFunction, uint64_t reorderWindow) :
+	timestampFunction(timestampFunction), reorderWindow(reorderWindow), nextSequence(0), newestTimestamp(0),
+	emittedTimestamp(0), emitted(false), lateItems(0) {
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicMerger<Type, Config>::add(SerialBasic<Type, Config>& port) {
+	Source source;
+	source.port = &port;
+	source.newestTimestamp = 0;
+	source.received = false;
+	sources.push_back(source);
+	return sources.size()-1;
+}
+
+template <class Type, class Config>
+template <class Handler>
+std::size_t SerialBasicMerger<Type, Config>::merge(Handler handler) {
+	Type items[READ_SIZE];
+	std::size_t lateEmittedItems = 0;
+	for (std::size_t index = 0; index < sources.size(); index++) {
+		Source& source = sources[index];
+		std::size_t readItems;
+		do {
+			readItems = source.port->read(items, READ_SIZE);
+			for (std::size_t i = 0; i < readItems; i++) {
+				Record record = {items[i], timestampFunction(items[i]), nextSequence++};
+				if (emitted && record.timestamp < emittedTimestamp) {
+					lateItems++;
+					lateEmittedItems++;
+					handler(index, (const Type&)record.item);
+					continue;
+				}
+				if (source.received == false || record.timestamp > source.newestTimestamp)
+					source.newestTimestamp = record.timestamp;
+				if (record.timestamp > newestTimestamp)
+					newestTimestamp = record.timestamp;
+				source.received = true;
+
+				// keep the port's records in timestamp order, pushing a new head if the oldest record changed
+				typename std::deque<Record>::iterator position = source.records.end();
+				while (position != source.records.begin() && (position-1)->timestamp > record.timestamp)
+					position--;
+				bool newHead = (position == source.records.begin());
+				source.records.insert(position, record);
+				if (newHead)
+					pushHead(index);
+			}
+		} while (readItems == READ_SIZE);
+	}
+	return lateEmittedItems+emit(handler, false);
+}
+
+template <class Type, class Config>
+template <class Handler>
+std::size_t SerialBasicMerger<Type, Config>::flush(Handler handler) {
+	return emit(handler, true);
+}
+
+template <class Type, class Config>
+uint64_t SerialBasicMerger<Type, Config>::getWatermark() {
+	uint64_t watermark = (newestTimestamp > reorderWindow) ? newestTimestamp-reorderWindow : 0;
+	if (sources.empty())
+		return watermark;
+	uint64_t oldestNewestTimestamp = sources[0].newestTimestamp;
+	for (std::size_t index = 1; index < sources.size(); index++)
+		if (sources[index].newestTimestamp < oldestNewestTimestamp)
+			oldestNewestTimestamp = sources[index].newestTimestamp;
+	return (oldestNewestTimestamp > watermark) ? oldestNewestTimestamp : watermark;
+}
+
+template <class Type, class Config>
+uint64_t SerialBasicMerger<Type, Config>::getLateItems() {
+	return lateItems;
+}
+
+template <class Type, class Config>
+template <class Handler>
+std::size_t SerialBasicMerger<Type, Config>::emit(Handler handler, bool all) {
+	uint64_t watermark = getWatermark();
+	std::size_t emittedItems = 0;
+	while (heads.empty() == false) {
+		Head head = heads.top();
+		Source& source = sources[head.index];
+
+		// heads are removed lazily, thus skip a head that is no longer the port's oldest record
+		if (source.records.empty() || source.records.front().sequence != head.sequence) {
+			heads.pop();
+			continue;
+		}
+		if (all == false && head.timestamp > watermark)
+			break;
+		heads.pop();
+		Record record = source.records.front();
+		source.records.pop_front();
+		if (source.records.empty() == false)
+			pushHead(head.index);
+		emittedTimestamp = record.timestamp;
+		emitted = true;
+		emittedItems++;
+		handler(head.index, (const Type&)record.item);
+	}
+	return emittedItems;
+}
+
+template <class Type, class Config>
+void SerialBasicMerger<Type, Config>::pushHead(std::size_t index) {
+	const Record& record = sources[index].records.front();
+	Head head = {record.timestamp, record.sequence, index};
+	heads.push(head);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,268 @@
+#ifndef SERIAL_BASIC_MESSAGES_H_
+#define SERIAL_BASIC_MESSAGES_H_
+
+#include "SerialBasic.h"
+#include "SerialBasicPipeline.h"
+#include <vector>
+#include <cstring>
+
+/**
+ * @file SerialBasicMessages.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicMessages;
+
+/**
+ * \brief Sends and receives variable-size messages over a SerialBasic object, framed by a length prefix
+ *
+ * Each message is framed as its length in bytes, encoded as an unsigned LEB128 varint of at most 5 bytes, followed by
+ * the payload and optionally by a CRC-16/CCITT of the payload (see SerialBasicCrc16), most significant byte first.
+ *
+ * A received message is delivered in place in the SerialBasic object's read buffer whenever the message is contiguous
+ * there, thus it is only copied when it wraps around the end of the read buffer (never, if the read buffer is
+ * mirrored), or when it is larger than the read buffer. A length larger than the maximum message size, or a CRC that
+ * does not match, is taken as corruption: a single byte is skipped and the next byte is taken as the start of a frame.
+ *
+ * While a SerialBasicMessages object is in use, the SerialBasic object should not be read by other means. Only
+ * SerialBasic objects whose Type is a single byte are supported. A SerialBasicMessages object is intended to be used by
+ * a single thread, apart from send(), which can be called concurrently.
+ */
+template <class Type, class Config>
+class SerialBasicMessages {
+public:
+	typedef typename SerialBasic<Type, Config>::Byte Byte;
+
+	/**
+	 * \brief Create a message channel over a SerialBasic object
+	 *
+	 * @param port The SerialBasic object. It must outlive the SerialBasicMessages object.
+	 * @param maxMessageSize The maximum size of a payload in bytes.
+	 * @param crc Whether frames end with a CRC of the payload.
+	 */
+	SerialBasicMessages(SerialBasic<Type, Config>& port, std::size_t maxMessageSize = 4096, bool crc = false);
+
+	/**
+	 * \brief Remove the last received message from the SerialBasic object's buffer
+	 */
+	~SerialBasicMessages();
+
+	/**
+	 * \brief Send a message (blocking)
+	 *
+	 * @param data The payload.
+	 * @param size The size of the payload in bytes.
+	 * @throw boost::system::system_error Thrown if the payload is larger than the maximum message size, or if writing
+	 * failed.
+	 */
+	void send(const Byte* data, std::size_t size);
+
+	/**
+	 * \brief Receive the next message (non-blocking)
+	 *
+	 * @param data Set to the payload, which remains valid until receive() is called again.
+	 * @param size Set to the size of the payload in bytes.
+	 * @return False if no complete message is buffered, in which case data and size are unchanged.
+	 */
+	bool receive(const Byte*& data, std::size_t& size);
+
+	/**
+	 * \brief Get the amount of bytes skipped because of corruption
+	 *
+	 * @return The amount of bytes skipped because a length exceeded the maximum message size or a CRC did not match.
+	 */
+	uint64_t getSkippedBytes();
+
+	/**
+	 * \brief Get the amount of messages received as a copy
+	 *
+	 * @return The amount of messages copied because they were not contiguous in the read buffer.
+	 */
+	uint64_t getCopiedMessages();
+private:
+	const static std::size_t MAX_HEADER_SIZE = 5;
+	static_assert(sizeof(Type) == 1, "SerialBasicMessages requires a Type of a single byte");
+	SerialBasic<Type, Config>& port;
+	std::size_t maxMessageSize;
+	bool crc;
+	std::size_t consumeSize;
+	std::vector<Byte> frame;
+	std::size_t frameSize;
+	std::size_t frameConsumeSize;
+	uint64_t skippedBytes;
+	uint64_t copiedMessages;
+	int parseHeader(const Byte* data, std::size_t size, std::size_t& payloadSize);
+	bool validate(const Byte* payload, std::size_t payloadSize);
+};
+
+template <class Type, class Config>
+SerialBasicMessages<Type, Config>::SerialBasicMessages(SerialBasic<Type, Config>& port, std::size_t maxMessageSize,
+	bool crc) : port(port), maxMessageSize(maxMessageSize), crc(crc), consumeSize(0),
+	frame(MAX_HEADER_SIZE+maxMessageSize+2), frameSize(0), frameConsumeSize(0), skippedBytes(0), copiedMessages(0) {
+}
+
+template <class Type, class Config>
+SerialBasicMessages<Type, Config>::~SerialBasicMessages() {
+	port.consume(consumeSize);
+}
+
+template <class Type, class Config>
+void SerialBasicMessages<Type, Config>::send(const Byte* data, std::size_t size) {
+	if (size > maxMessageSize)
+		throw boost::system::system_error(boost::system::errc::make_error_code(
+			boost::system::errc::message_size));
+
+	// the frame is written at once, so that the frames of concurrent calls are not interleaved
+	std::vector<Byte> sendFrame;
+	sendFrame.reserve(MAX_HEADER_SIZE+size+2);
+	std::size_t length = size;
+	do {
+		sendFrame.push_back((Byte)((length & 0x7F) | ((length > 0x7F) ? 0x80 : 0)));
+		length >>= 7;
+	} while (length != 0);
+	sendFrame.insert(sendFrame.end(), data, data+size);
+	if (crc) {
+		uint16_t checksum = SerialBasicCrc16::compute(data, size);
+		sendFrame.push_back((Byte)(checksum >> 8));
+		sendFrame.push_back((Byte)(checksum & 0xFF));
+	}
+	port.write((const Type*)sendFrame.data(), sendFrame.size());
+}
+
+template <class Type, class Config>
+bool SerialBasicMessages<Type, Config>::receive(const Byte*& data, std::size_t& size) {
+
+	// the previous message is consumed only now, since it was delivered in place
+	port.consume(consumeSize);
+	consumeSize = 0;
+
+	// a frame that was resynchronized within the copy may be followed by bytes of the next frames, which are kept
+	frameSize -= frameConsumeSize;
+	std::memmove(frame.data(), frame.data()+frameConsumeSize, frameSize);
+	frameConsumeSize = 0;
+	while (true) {
+		std::size_t payloadSize;
+		int headerSize;
+		if (frameSize != 0) {
+
+			// a frame that is not contiguous is assembled in a copy
+			headerSize = parseHeader(frame.data(), frameSize, payloadSize);
+			std::size_t neededSize = (headerSize > 0) ? headerSize+payloadSize+(crc ? 2 : 0) : frameSize+1;
+			if (headerSize >= 0 && frameSize < neededSize) {
+				std::size_t readSize = port.read(frame.data()+frameSize, neededSize-frameSize);
+				if (readSize == 0)
+					return false;
+				frameSize += readSize;
+				continue;
+			}
+			if (headerSize > 0 && validate(frame.data()+headerSize, payloadSize)) {
+				frameConsumeSize = neededSize;
+				copiedMessages++;
+				data = frame.data()+headerSize;
+				size = payloadSize;
+				return true;
+			}
+
+			// corrupted, thus the frame's first byte is skipped and the rest is parsed again
+			skippedBytes++;
+			frameSize--;
+			std::memmove(frame.data(), frame.data()+1, frameSize);
+			continue;
+		}
+		const Byte* buffered;
+		std::size_t contiguousSize = port.peek(buffered);
+		std::size_t bufferedSize = port.available();
+		if (bufferedSize == 0)
+			return false;
+		headerSize = parseHeader(buffered, contiguousSize, payloadSize);
+		if (headerSize > 0) {
+			std::size_t neededSize = headerSize+payloadSize+(crc ? 2 : 0);
+			if (neededSize <= contiguousSize) {
+				if (validate(buffered+headerSize, payloadSize) == false) {
+					skippedBytes++;
+					port.consume(1);
+					continue;
+				}
+				consumeSize = neededSize;
+				data = buffered+headerSize;
+				size = payloadSize;
+				return true;
+			}
+
+			// a frame that does not fit in the read buffer would never be complete there
+			if (neededSize <= bufferedSize || neededSize > Config::READ_BUFFER_SIZE)
+				frameSize = port.read(frame.data(), (neededSize < bufferedSize) ? neededSize : bufferedSize);
+			else
+				return false;
+		} else if (headerSize < 0) {
+			skippedBytes++;
+			port.consume(1);
+		} else if (contiguousSize < bufferedSize) {
+			frameSize = port.read(frame.data(), contiguousSize);
+		} else {
+			return false;
+		}
+	}
+}
+
+template <class Type, class Config>
+uint64_t SerialBasicMessages<Type, Config>::getSkippedBytes() {
+	return skippedBytes;
+}
+
+template <class Type, class Config>
+uint64_t SerialBasicMessages<Type, Config>::getCopiedMessages() {
+	return copiedMessages;
+}
+
+template <class Type, class Config>
+int SerialBasicMessages<Type, Config>::parseHeader(const Byte* data, std::size_t size, std::size_t& payloadSize) {
+
+	// returns the size of the header, 0 if it is incomplete, or -1 if it is corrupted
+	uint64_t length = 0;
+	for (std::size_t i = 0; i < MAX_HEADER_SIZE; i++) {
+		if (i == size)
+			return 0;
+		length |= ((uint64_t)(data[i] & 0x7F)) << (7*i);
+		if ((data[i] & 0x80) == 0) {
+			if (length > maxMessageSize)
+				return -1;
+			payloadSize = (std::size_t)length;
+			return (int)i+1;
+		}
+	}
+	return -1;
+}
+
+template <class Type, class Config>
+bool SerialBasicMessages<Type, Config>::validate(const Byte* payload, std::size_t payloadSize) {
+	if (crc == false)
+		return true;
+	uint16_t checksum = (uint16_t)((payload[payloadSize] << 8) | payload[payloadSize+1]);
+	return SerialBasicCrc16::compute(payload, payloadSize) == checksum;
+}
+
+#endif
\ No newline at end of file
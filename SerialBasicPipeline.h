@@ -0,0 +1,324 @@
+#ifndef SERIAL_BASIC_PIPELINE_H_
+#define SERIAL_BASIC_PIPELINE_H_
+
+#include "SerialBasic.h"
+#include <tuple>
+#include <atomic>
+#include <cstring>
+
+/**
+ * @file SerialBasicPipeline.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+/**
+ * \brief Pipeline stage that removes COBS (Consistent Overhead Byte Stuffing) framing
+ *
+ * Frames are delimited by a zero byte. Each decoded frame is passed to the next stage as (const uint8_t* data,
+ * std::size_t size), directly from the stage's frame buffer.
+ *
+ * @tparam MaxFrameSize The maximum size of a decoded frame in bytes. Longer frames are dropped and counted.
+ */
+template <std::size_t MaxFrameSize = 256>
+class SerialBasicCobs {
+public:
+	SerialBasicCobs() : code(0), remaining(0), frameSize(0), overflowed(false), malformedFrames(0) {}
+
+	/**
+	 * \brief Decode a chunk of bytes, passing every completed frame to the next stage
+	 */
+	template <class Next>
+	void process(const uint8_t* data, std::size_t size, Next& next) {
+		for (std::size_t i = 0; i < size; i++) {
+			uint8_t byte = data[i];
+			if (byte == 0) {
+				if (code != 0) {
+					if (remaining == 0 && overflowed == false)
+						next((const uint8_t*)frame, frameSize);
+					else
+						malformedFrames++;
+				}
+				code = 0;
+				remaining = 0;
+				frameSize = 0;
+				overflowed = false;
+			} else if (remaining == 0) {
+
+				// a code byte, which follows a zero unless the previous block was a full block of 254 bytes
+				if (code != 0 && code != 0xFF)
+					append(0);
+				code = byte;
+				remaining = byte-1;
+			} else {
+				append(byte);
+				remaining--;
+			}
+		}
+	}
+
+	/**
+	 * \brief Get the amount of frames dropped because they were malformed or longer than MaxFrameSize
+	 */
+	uint64_t getMalformedFrames() const {
+		return malformedFrames.load();
+	}
+private:
+	uint8_t frame[MaxFrameSize];
+	uint8_t code;
+	uint8_t remaining;
+	std::size_t frameSize;
+	bool overflowed;
+	std::atomic<uint64_t> malformedFrames;
+	void append(uint8_t byte) {
+		if (frameSize == MaxFrameSize)
+			overflowed = true;
+		else
+			frame[frameSize++] = byte;
+	}
+};
+
+/**
+ * \brief Pipeline stage that validates the CRC-16/CCITT (polynomial 0x1021, initial value 0xFFFF) of each frame
+ *
+ * The last two bytes of a frame are its CRC, most significant byte first. The rest of a valid frame is passed to the
+ * next stage in place, and invalid frames are dropped and counted.
+ */
+class SerialBasicCrc16 {
+public:
+	SerialBasicCrc16() : invalidFrames(0) {}
+
+	/**
+	 * \brief Validate a frame, passing its payload to the next stage if it is valid
+	 */
+	template <class Next>
+	void process(const uint8_t* data, std::size_t size, Next& next) {
+		if (size < 2 || compute(data, size-2) != (uint16_t)((data[size-2] << 8) | data[size-1])) {
+			invalidFrames++;
+			return;
+		}
+		next(data, size-2);
+	}
+
+	/**
+	 * \brief Compute the CRC of data
+	 */
+	static uint16_t compute(const uint8_t* data, std::size_t size) {
+		static const Table table;
+		uint16_t crc = 0xFFFF;
+		for (std::size_t i = 0; i < size; i++)
+			crc = (uint16_t)((crc << 8) ^ table.entries[(crc >> 8) ^ data[i]]);
+		return crc;
+	}
+
+	/**
+	 * \brief Get the amount of frames dropped because their CRC did not match
+	 */
+	uint64_t getInvalidFrames() const {
+		return invalidFrames.load();
+	}
+private:
+	struct Table {
+		uint16_t entries[256];
+		Table() {
+			for (unsigned int i = 0; i < 256; i++) {
+				uint16_t crc = (uint16_t)(i << 8);
+				for (int bit = 0; bit < 8; bit++)
+					crc = (uint16_t)((crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1);
+				entries[i] = crc;
+			}
+		}
+	};
+	std::atomic<uint64_t> invalidFrames;
+};
+
+/**
+ * \brief Pipeline stage that decodes each frame into an item
+ *
+ * A frame of exactly sizeof(Item) bytes is copied into an item, which is passed to the next stage as (const Item&).
+ * Thus this stage is the last one, and the pipeline's sink receives items. Frames of other sizes are dropped and
+ * counted.
+ */
+template <class Item>
+class SerialBasicDecode {
+public:
+	SerialBasicDecode() : invalidFrames(0) {}
+
+	/**
+	 * \brief Decode a frame, passing the item to the next stage
+	 */
+	template <class Next>
+	void process(const uint8_t* data, std::size_t size, Next& next) {
+		if (size != sizeof(Item)) {
+			invalidFrames++;
+			return;
+		}
+		Item item;
+		std::memcpy((void*)&item, data, sizeof(Item));
+		next((const Item&)item);
+	}
+
+	/**
+	 * \brief Get the amount of frames dropped because their size was not sizeof(Item)
+	 */
+	uint64_t getInvalidFrames() const {
+		return invalidFrames.load();
+	}
+private:
+	std::atomic<uint64_t> invalidFrames;
+};
+
+/**
+ * \brief Runs received data through stages that are composed at compile time, e.g.
+ * SerialBasicPipeline<SerialBasicCobs<>, SerialBasicCrc16, SerialBasicDecode<Message> >
+ *
+ * A stage is any class with a method template <class Next> void process(const uint8_t* data, std::size_t size,
+ * Next& next), which calls next with its output, e.g. a deframer calls next with each frame and a decompressor with
+ * each decompressed block. Each stage calls the next one directly, thus the stages are inlined into one pass over each
+ * chunk, without virtual calls. Downstream stages work in place on the output of the stage before, so no buffer is
+ * needed between stages other than the state of a stage itself (e.g. the frame being deframed). The sink is called
+ * with the output of the last stage.
+ *
+ * Once attached to a SerialBasic object, the pipeline runs on the io service thread for every received chunk, thus
+ * the sink should return quickly. The stages are accessed with getStage(), and their counters can be read from any
+ * thread.
+ */
+template <class... Stages>
+class SerialBasicPipeline {
+public:
+	SerialBasicPipeline();
+
+	/**
+	 * \brief Detach the pipeline from its SerialBasic object, if any
+	 */
+	~SerialBasicPipeline();
+
+	/**
+	 * \brief Run data through the stages
+	 *
+	 * @param data The data.
+	 * @param size The size of the data in bytes.
+	 * @param sink Called with the output of the last stage.
+	 */
+	template <class Sink>
+	void push(const uint8_t* data, std::size_t size, Sink& sink);
+
+	/**
+	 * \brief Run every chunk received by a SerialBasic object through the stages
+	 *
+	 * The SerialBasic object still saves the received data to its buffer.
+	 *
+	 * @param port The SerialBasic object. It must outlive the SerialBasicPipeline object, or be detached first.
+	 * @param sink Called with the output of the last stage, on the io service thread.
+	 */
+	template <class Type, class Config, class Sink>
+	void attach(SerialBasic<Type, Config>& port, Sink sink);
+
+	/**
+	 * \brief Stop running received chunks through the stages
+	 */
+	void detach();
+
+	/**
+	 * \brief Get a stage
+	 *
+	 * @tparam Index The index of the stage.
+	 * @return The stage.
+	 */
+	template <std::size_t Index>
+	typename std::tuple_element<Index, std::tuple<Stages...> >::type& getStage() {
+		return std::get<Index>(stages);
+	}
+private:
+	static_assert(sizeof...(Stages) != 0, "A pipeline needs at least one stage");
+	template <std::size_t Index, class Sink>
+	struct Next {
+		SerialBasicPipeline* pipeline;
+		Sink* sink;
+		void operator()(const uint8_t* data, std::size_t size) const {
+			pipeline->process<Index>(data, size, *sink,
+				std::integral_constant<bool, (Index+1 < sizeof...(Stages))>());
+		}
+	};
+	std::tuple<Stages...> stages;
+	std::function<void()> detachFunction;
+	template <std::size_t Index, class Sink>
+	void process(const uint8_t* data, std::size_t size, Sink& sink, std::true_type);
+	template <std::size_t Index, class Sink>
+	void process(const uint8_t* data, std::size_t size, Sink& sink, std::false_type);
+};
+
+template <class... Stages>
+SerialBasicPipeline<Stages...>::SerialBasicPipeline() {
+}
+
+template <class... Stages>
+SerialBasicPipeline<Stages...>::~SerialBasicPipeline() {
+	detach();
+}
+
+template <class... Stages>
+template <class Sink>
+void SerialBasicPipeline<Stages...>::push(const uint8_t* data, std::size_t size, Sink& sink) {
+	process<0>(data, size, sink, std::integral_constant<bool, (1 < sizeof...(Stages))>());
+}
+
+template <class... Stages>
+template <class Type, class Config, class Sink>
+void SerialBasicPipeline<Stages...>::attach(SerialBasic<Type, Config>& port, Sink sink) {
+	detach();
+	std::size_t receiveHandlerId = port.addReceiveHandler(
+		[this, sink](const typename SerialBasic<Type, Config>::Byte* data, std::size_t size) mutable ->void{
+			push(data, size, sink);
+		});
+	detachFunction = [receiveHandlerId, &port]()->void{
+		port.removeReceiveHandler(receiveHandlerId);
+	};
+}
+
+template <class... Stages>
+void SerialBasicPipeline<Stages...>::detach() {
+	if (detachFunction) {
+		detachFunction();
+		detachFunction = std::function<void()>();
+	}
+}
+
+template <class... Stages>
+template <std::size_t Index, class Sink>
+void SerialBasicPipeline<Stages...>::process(const uint8_t* data, std::size_t size, Sink& sink, std::true_type) {
+
+	// more stages follow, thus the stage's output goes to the next stage
+	Next<Index+1, Sink> next = {this, &sink};
+	std::get<Index>(stages).process(data, size, next);
+}
+
+template <class... Stages>
+template <std::size_t Index, class Sink>
+void SerialBasicPipeline<Stages...>::process(const uint8_t* data, std::size_t size, Sink& sink, std::false_type) {
+	std::get<Index>(stages).process(data, size, sink);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,240 @@
+#ifndef SERIAL_BASIC_PORT_SET_H_
+#define SERIAL_BASIC_PORT_SET_H_
+
+#include "SerialBasic.h"
+#include <vector>
+#include <atomic>
+
+/**
+ * @file SerialBasicPortSet.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicPortSet;
+
+/**
+ * \brief Reports which of many SerialBasic objects have data, and reads them in one call
+ *
+ * Polling many SerialBasic objects with read() locks every object, even those without data. Instead, the io service
+ * thread of each port in a SerialBasicPortSet sets the port's bit in a shared readiness bitmap once the port has a
+ * complete item, thus the cost of a poll scales with the amount of ready ports rather than the total amount of ports.
+ *
+ * A SerialBasicPortSet object is intended to be used by a single thread.
+ */
+template <class Type, class Config>
+class SerialBasicPortSet {
+public:
+	typedef typename SerialBasic<Type, Config>::Byte Byte;
+
+	/**
+	 * \brief Create an empty port set
+	 *
+	 * @param maxPorts The maximum amount of ports that can be added.
+	 */
+	SerialBasicPortSet(std::size_t maxPorts = 64);
+
+	/**
+	 * \brief Remove all ports
+	 */
+	~SerialBasicPortSet();
+
+	/**
+	 * \brief Add a port
+	 *
+	 * @param port The SerialBasic object. It must outlive the SerialBasicPortSet object, or be removed first.
+	 * @return The index of the port, which identifies it in wait() and drain().
+	 * @throw boost::system::system_error Thrown if maxPorts ports were already added.
+	 */
+	std::size_t add(SerialBasic<Type, Config>& port);
+
+	/**
+	 * \brief Remove a port
+	 *
+	 * @param index The index returned by add(). The index can be reused by a later add().
+	 */
+	void remove(std::size_t index);
+
+	/**
+	 * \brief Wait for ports to have data (blocking)
+	 *
+	 * A port may be reported even though another read emptied it since its bit was set.
+	 *
+	 * @param readyPorts Cleared, then filled with the indices of the ready ports. The ports' bits are cleared.
+	 * @param timeout The maximum time to wait in milliseconds. 0 polls without waiting.
+	 * @return The amount of ready ports.
+	 */
+	std::size_t wait(std::vector<std::size_t>& readyPorts, uint32_t timeout = 0);
+
+	/**
+	 * \brief Read every available item from the ready ports (blocking)
+	 *
+	 * The handler is called with (std::size_t index, const Type* items, std::size_t count) for each batch of items read
+	 * from a ready port.
+	 *
+	 * @param handler The handler.
+	 * @param timeout The maximum time to wait for a ready port in milliseconds. 0 polls without waiting.
+	 * @return The total amount of items read.
+	 */
+	template <class Handler>
+	std::size_t drain(Handler handler, uint32_t timeout = 0);
+private:
+	struct Member {
+		SerialBasic<Type, Config>* port;
+		std::size_t receiveHandlerId;
+	};
+	const static std::size_t BITS_PER_WORD = 64;
+	const static std::size_t READ_SIZE = 64;
+	boost::mutex mutex;
+	boost::condition_variable readyCondition;
+	std::vector<Member> members;
+	std::unique_ptr<std::atomic<uint64_t>[]> readyBitmap;
+	std::size_t wordCount;
+	std::atomic<bool> waiting;
+	std::vector<std::size_t> readyPorts;
+	std::size_t collect(std::vector<std::size_t>& readyPorts);
+	static std::size_t lowestBit(uint64_t word);
+};
+
+template <class Type, class Config>
+SerialBasicPortSet<Type, Config>::SerialBasicPortSet(std::size_t maxPorts) : members(maxPorts),
+	wordCount((maxPorts+BITS_PER_WORD-1)/BITS_PER_WORD), waiting(false) {
+		readyBitmap.reset(new std::atomic<uint64_t>[wordCount]);
+		for (std::size_t i = 0; i < wordCount; i++)
+			readyBitmap[i].store(0);
+		for (std::size_t i = 0; i < maxPorts; i++)
+			members[i].port = NULL;
+}
+
+template <class Type, class Config>
+SerialBasicPortSet<Type, Config>::~SerialBasicPortSet() {
+	for (std::size_t i = 0; i < members.size(); i++)
+		remove(i);
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicPortSet<Type, Config>::add(SerialBasic<Type, Config>& port) {
+	std::size_t index = 0;
+	while (index < members.size() && members[index].port != NULL)
+		index++;
+	if (index == members.size())
+		throw boost::system::system_error(boost::system::errc::make_error_code(
+			boost::system::errc::no_buffer_space));
+	members[index].port = &port;
+	members[index].receiveHandlerId = port.addReceiveHandler([this, index, &port](const Byte*, std::size_t)->void{
+
+		// the port is locked while the handler runs, thus available() is consistent with the received chunk
+		if (port.available() == 0)
+			return;
+		readyBitmap[index/BITS_PER_WORD].fetch_or(((uint64_t)1) << (index%BITS_PER_WORD));
+		if (waiting.load()) {
+			boost::unique_lock<boost::mutex> scoped_lock(mutex);
+			readyCondition.notify_one();
+		}
+	});
+
+	// the port may already have data
+	if (port.available() != 0)
+		readyBitmap[index/BITS_PER_WORD].fetch_or(((uint64_t)1) << (index%BITS_PER_WORD));
+	return index;
+}
+
+template <class Type, class Config>
+void SerialBasicPortSet<Type, Config>::remove(std::size_t index) {
+	if (members[index].port == NULL)
+		return;
+	members[index].port->removeReceiveHandler(members[index].receiveHandlerId);
+	members[index].port = NULL;
+	readyBitmap[index/BITS_PER_WORD].fetch_and(~(((uint64_t)1) << (index%BITS_PER_WORD)));
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicPortSet<Type, Config>::wait(std::vector<std::size_t>& readyPorts, uint32_t timeout) {
+	readyPorts.clear();
+	if (collect(readyPorts) != 0 || timeout == 0)
+		return readyPorts.size();
+
+	// the waiting flag is set before the bitmap is checked again, so a port that becomes ready meanwhile notifies
+	boost::system_time deadline = boost::get_system_time()+boost::posix_time::milliseconds(timeout);
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	waiting.store(true);
+	while (collect(readyPorts) == 0) {
+		if (readyCondition.timed_wait(scoped_lock, deadline) == false) {
+			collect(readyPorts);
+			break;
+		}
+	}
+	waiting.store(false);
+	return readyPorts.size();
+}
+
+template <class Type, class Config>
+template <class Handler>
+std::size_t SerialBasicPortSet<Type, Config>::drain(Handler handler, uint32_t timeout) {
+	Type items[READ_SIZE];
+	std::size_t totalItems = 0;
+	wait(readyPorts, timeout);
+	for (std::size_t i = 0; i < readyPorts.size(); i++) {
+		std::size_t index = readyPorts[i];
+		std::size_t readItems;
+		do {
+			readItems = members[index].port->read(items, READ_SIZE);
+			if (readItems != 0)
+				handler(index, (const Type*)items, readItems);
+			totalItems += readItems;
+		} while (readItems == READ_SIZE);
+	}
+	return totalItems;
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicPortSet<Type, Config>::collect(std::vector<std::size_t>& readyPorts) {
+	for (std::size_t i = 0; i < wordCount; i++) {
+		if (readyBitmap[i].load(std::memory_order_relaxed) == 0)
+			continue;
+		uint64_t word = readyBitmap[i].exchange(0);
+		while (word != 0) {
+			readyPorts.push_back(i*BITS_PER_WORD+lowestBit(word));
+			word &= word-1;
+		}
+	}
+	return readyPorts.size();
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicPortSet<Type, Config>::lowestBit(uint64_t word) {
+#if defined(__GNUC__)
+	return (std::size_t)__builtin_ctzll(word);
+#else
+	std::size_t bit = 0;
+	while ((word&1) == 0) {
+		word >>= 1;
+		bit++;
+	}
+	return bit;
+#endif
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,297 @@
+#ifndef SERIAL_BASIC_SCHEDULER_H_
+#define SERIAL_BASIC_SCHEDULER_H_
+
+#include "SerialBasic.h"
+#include <boost/asio/steady_timer.hpp>
+#include <vector>
+#include <chrono>
+#include <cstring>
+
+/**
+ * @file SerialBasicScheduler.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicScheduler;
+
+/**
+ * \brief Writes periodic messages (e.g. heartbeats and setpoints) to a SerialBasic object at fixed rates
+ *
+ * Each periodic message is sent from the SerialBasic object's io service thread when a steady timer expires. Deadlines
+ * are absolute, i.e. the n-th message is due exactly n periods after the first, thus timer latency never accumulates
+ * into drift. If a deadline is missed by more than a period, the missed deadlines are skipped and counted, as opposed to
+ * sending a burst of messages.
+ *
+ * The message is produced by a callback at send time, thus the latest value is always sent. The lateness of every send
+ * relative to its deadline is recorded in a histogram. Messages are written asynchronously, so the io service thread
+ * never blocks on the serial port, and a deadline at which the previous message is still being written is skipped.
+ */
+template <class Type, class Config>
+class SerialBasicScheduler {
+public:
+
+	/**
+	 * \brief Produces a message at send time
+	 *
+	 * Called with (Type* items, std::size_t maxSize) and returns the amount of items of the message, which may be 0 to
+	 * skip a send.
+	 */
+	typedef std::function<std::size_t(Type*, std::size_t)> Producer;
+
+	/**
+	 * \brief The amount of buckets of the jitter histogram
+	 *
+	 * Bucket 0 counts sends less than 1 microsecond late, and bucket i counts sends at least 2^(i-1) and less than 2^i
+	 * microseconds late. The last bucket also counts every later send.
+	 */
+	const static std::size_t HISTOGRAM_SIZE = 24;
+
+	/**
+	 * \brief Statistics of a periodic message
+	 */
+	struct Statistics {
+		uint64_t sentMessages;					/**< The amount of messages sent */
+		uint64_t skippedDeadlines;				/**< The amount of deadlines missed or skipped */
+		uint64_t maxJitter;						/**< The largest lateness of a send in microseconds */
+		uint64_t histogram[HISTOGRAM_SIZE];		/**< The jitter histogram */
+	};
+
+	/**
+	 * \brief Create a scheduler without periodic messages
+	 *
+	 * @param port The SerialBasic object. It must outlive the SerialBasicScheduler object.
+	 */
+	SerialBasicScheduler(SerialBasic<Type, Config>& port);
+
+	/**
+	 * \brief Remove all periodic messages
+	 */
+	~SerialBasicScheduler();
+
+	/**
+	 * \brief Add a periodic message
+	 *
+	 * @param period The period in microseconds.
+	 * @param maxSize The maximum amount of items of the message.
+	 * @param producer Produces the message at send time, on the io service thread.
+	 * @return An identifier of the periodic message.
+	 */
+	std::size_t add(uint32_t period, std::size_t maxSize, Producer producer);
+
+	/**
+	 * \brief Remove a periodic message
+	 *
+	 * Once this method returns, the producer is no longer called.
+	 *
+	 * @param id The identifier returned by add().
+	 */
+	void remove(std::size_t id);
+
+	/**
+	 * \brief Get the statistics of a periodic message
+	 *
+	 * @param id The identifier returned by add().
+	 * @return The statistics.
+	 */
+	Statistics getStatistics(std::size_t id);
+
+	/**
+	 * \brief Get boost error code
+	 *
+	 * The error code is set if writing a periodic message failed.
+	 *
+	 * @return The boost error code.
+	 */
+	boost::system::error_code& getErrorCode();
+private:
+	typedef std::chrono::steady_clock Clock;
+	struct Periodic {
+		boost::mutex mutex;
+		bool active;
+		bool writing;
+		boost::asio::steady_timer timer;
+		Clock::duration period;
+		Clock::time_point deadline;
+		Producer producer;
+		std::vector<Type> message;
+		Statistics statistics;
+		Periodic(boost::asio::io_service& io) : active(true), writing(false), timer(io) {}
+	};
+	typedef std::shared_ptr<Periodic> PeriodicPointer;
+	SerialBasic<Type, Config>& port;
+	boost::mutex mutex;
+	std::map<std::size_t, PeriodicPointer> periodics;
+	std::size_t nextId;
+	boost::system::error_code errorCode;
+	void setAsynchronousWait(PeriodicPointer periodic);
+	void send(PeriodicPointer periodic);
+};
+
+template <class Type, class Config>
+SerialBasicScheduler<Type, Config>::SerialBasicScheduler(SerialBasic<Type, Config>& port) : port(port), nextId(0) {
+}
+
+template <class Type, class Config>
+SerialBasicScheduler<Type, Config>::~SerialBasicScheduler() {
+	std::vector<std::size_t> ids;
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(mutex);
+		for (auto periodic = periodics.begin(); periodic != periodics.end(); periodic++)
+			ids.push_back(periodic->first);
+	}
+	for (std::size_t i = 0; i < ids.size(); i++)
+		remove(ids[i]);
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicScheduler<Type, Config>::add(uint32_t period, std::size_t maxSize, Producer producer) {
+	PeriodicPointer periodic(new Periodic(port.getIoService()));
+	periodic->period = std::chrono::microseconds(period);
+	periodic->deadline = Clock::now()+periodic->period;
+	periodic->producer = producer;
+	periodic->message.resize(maxSize);
+	std::memset(&periodic->statistics, 0, sizeof(Statistics));
+	std::size_t id;
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(mutex);
+		id = nextId++;
+		periodics[id] = periodic;
+	}
+	setAsynchronousWait(periodic);
+	return id;
+}
+
+template <class Type, class Config>
+void SerialBasicScheduler<Type, Config>::remove(std::size_t id) {
+	PeriodicPointer periodic;
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(mutex);
+		auto iterator = periodics.find(id);
+		if (iterator == periodics.end())
+			return;
+		periodic = iterator->second;
+		periodics.erase(iterator);
+	}
+
+	// waits for a send in progress, and timers are only touched from the io service thread
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(periodic->mutex);
+		periodic->active = false;
+	}
+	port.getIoService().post([periodic]()->void{
+		periodic->timer.cancel();
+	});
+}
+
+template <class Type, class Config>
+typename SerialBasicScheduler<Type, Config>::Statistics SerialBasicScheduler<Type, Config>::getStatistics(std::size_t id) {
+	PeriodicPointer periodic;
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(mutex);
+		periodic = periodics.at(id);
+	}
+	boost::unique_lock<boost::mutex> scoped_lock(periodic->mutex);
+	return periodic->statistics;
+}
+
+template <class Type, class Config>
+boost::system::error_code& SerialBasicScheduler<Type, Config>::getErrorCode() {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	return errorCode;
+}
+
+template <class Type, class Config>
+void SerialBasicScheduler<Type, Config>::setAsynchronousWait(PeriodicPointer periodic) {
+	periodic->timer.expires_at(periodic->deadline);
+	periodic->timer.async_wait([this, periodic](const boost::system::error_code& error)->void{
+		if (error)
+			return;
+		send(periodic);
+	});
+}
+
+template <class Type, class Config>
+void SerialBasicScheduler<Type, Config>::send(PeriodicPointer periodic) {
+	boost::unique_lock<boost::mutex> scoped_lock(periodic->mutex);
+	if (periodic->active == false)
+		return;
+
+	// record the lateness of the send
+	Clock::time_point now = Clock::now();
+	uint64_t jitter = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now-periodic->deadline).count();
+	std::size_t bucket = 0;
+	while (bucket < HISTOGRAM_SIZE-1 && (((uint64_t)1) << bucket) <= jitter)
+		bucket++;
+	Statistics& statistics = periodic->statistics;
+	statistics.histogram[bucket]++;
+	if (jitter > statistics.maxJitter)
+		statistics.maxJitter = jitter;
+
+	// produce and send the latest message, unless the previous message is still being written from the same buffer
+	std::size_t size = 0;
+	if (periodic->writing)
+		statistics.skippedDeadlines++;
+	else
+		size = periodic->producer(periodic->message.data(), periodic->message.size());
+	if (size > periodic->message.size())
+		size = periodic->message.size();
+	if (size != 0) {
+		try {
+			periodic->writing = true;
+			port.asyncWrite(periodic->message.data(), size, [this, periodic](const boost::system::error_code& error)
+				->void{
+				boost::unique_lock<boost::mutex> scoped_lock(periodic->mutex);
+				periodic->writing = false;
+				if (!error) {
+					periodic->statistics.sentMessages++;
+					return;
+				}
+
+				// a removed message may outlive the scheduler
+				if (periodic->active == false)
+					return;
+				boost::unique_lock<boost::mutex> error_lock(mutex);
+				errorCode = error;
+			});
+		} catch (boost::system::system_error& e) {
+			periodic->writing = false;
+			boost::unique_lock<boost::mutex> scoped_lock(mutex);
+			errorCode = e.code();
+		}
+	}
+
+	// the next deadline stays on the grid of the first, skipping deadlines that were already missed
+	periodic->deadline += periodic->period;
+	now = Clock::now();
+	if (periodic->deadline <= now) {
+		uint64_t missedDeadlines = (uint64_t)((now-periodic->deadline)/periodic->period)+1;
+		statistics.skippedDeadlines += missedDeadlines;
+		periodic->deadline += periodic->period*missedDeadlines;
+	}
+	setAsynchronousWait(periodic);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,363 @@
+#ifndef SERIAL_BASIC_SHARED_RING_H_
+#define SERIAL_BASIC_SHARED_RING_H_
+
+#include "SerialBasic.h"
+#include <boost/interprocess/shared_memory_object.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <atomic>
+#include <cstring>
+
+/**
+ * @file SerialBasicSharedRing.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicSharedRingWriter;
+template <class Type = uint8_t> class SerialBasicSharedRingReader;
+
+/**
+ * \brief Layout of the beginning of a shared ring's shared memory object
+ *
+ * The ring's data immediately follows this header. Sequences count bytes since the ring was created and never wrap,
+ * thus the position of a byte in the data is its sequence modulo the capacity.
+ */
+struct SerialBasicSharedRingHeader {
+	const static uint64_t MAGIC = 0x5342534852494e47ULL;
+	std::atomic<uint64_t> magic;
+	uint64_t capacity;
+	std::atomic<uint64_t> reserveSequence;
+	std::atomic<uint64_t> writeSequence;
+	uint8_t padding[32];
+};
+
+/**
+ * \brief Publishes the receive stream of a SerialBasic object into a shared memory ring
+ *
+ * There is a single writer for each ring, while any amount of SerialBasicSharedRingReader objects in any process can
+ * consume the ring independently. The writer never waits for readers; a reader that falls behind by more than the
+ * ring's capacity detects the overrun and skips ahead.
+ *
+ * Shared memory is managed with boost interprocess, thus the ring is available on every operating system supported by
+ * boost interprocess.
+ */
+template <class Type, class Config>
+class SerialBasicSharedRingWriter {
+public:
+	typedef typename SerialBasic<Type, Config>::Byte Byte;
+
+	/**
+	 * \brief Create a shared ring and publish every chunk received by port into it
+	 *
+	 * @param port The SerialBasic object whose receive stream is published. It must outlive the
+	 * SerialBasicSharedRingWriter object.
+	 * @param name The name of the shared memory object. Any existing shared memory object with the name is removed.
+	 * @param capacity The capacity of the ring in bytes. Must be a power of two and a multiple of sizeof(Type).
+	 * @throw boost::system::system_error Thrown if capacity is invalid.
+	 * @throw boost::interprocess::interprocess_exception Thrown if the shared memory object could not be created.
+	 */
+	SerialBasicSharedRingWriter(SerialBasic<Type, Config>& port, const std::string& name, std::size_t capacity = 65536);
+
+	/**
+	 * \brief Stop publishing and remove the shared memory object
+	 *
+	 * Readers that already opened the ring can still consume the data remaining in it.
+	 */
+	~SerialBasicSharedRingWriter();
+
+	/**
+	 * \brief Publish bytes into the ring
+	 *
+	 * Called for every chunk received by the port, but can also be called directly. Must not be called concurrently.
+	 *
+	 * @param data The bytes to publish.
+	 * @param size The amount of bytes to publish.
+	 */
+	void publish(const Byte* data, std::size_t size);
+private:
+	SerialBasic<Type, Config>& port;
+	std::string name;
+	boost::interprocess::shared_memory_object sharedMemory;
+	boost::interprocess::mapped_region region;
+	SerialBasicSharedRingHeader* header;
+	Byte* data;
+	std::size_t receiveHandlerId;
+};
+
+/**
+ * \brief Consumes a shared ring published by a SerialBasicSharedRingWriter, without copying or system calls
+ *
+ * Each reader tracks its own sequence cursor, thus readers do not affect each other or the writer. Data can either be
+ * copied out as Type items with read(), or accessed in place with peek() and consume().
+ */
+template <class Type>
+class SerialBasicSharedRingReader {
+public:
+	typedef uint8_t Byte;
+
+	/**
+	 * \brief Open an existing shared ring
+	 *
+	 * The reader starts at the current end of the ring, thus only data published after the reader was opened is read.
+	 *
+	 * @param name The name of the shared memory object.
+	 * @throw boost::system::system_error Thrown if the shared memory object is not a shared ring, or if its capacity is
+	 * not a power of two that fits in the shared memory object.
+	 * @throw boost::interprocess::interprocess_exception Thrown if the shared memory object could not be opened.
+	 */
+	SerialBasicSharedRingReader(const std::string& name);
+
+	/**
+	 * \brief Get the amount of complete Type items that can be read
+	 *
+	 * @return The amount of complete items between the reader's cursor and the end of the ring.
+	 */
+	std::size_t available();
+
+	/**
+	 * \brief Read Type items from the ring (non-blocking)
+	 *
+	 * @param beginIterator The starting location of where the data is saved.
+	 * @param size The maximum amount of items to copy.
+	 * @return The actual amount of items saved.
+	 */
+	template <class BeginIterator>
+	std::size_t read(BeginIterator beginIterator, std::size_t size);
+
+	/**
+	 * \brief Access the unread bytes in place
+	 *
+	 * Because the ring wraps, the unread bytes are described by up to two spans. The spans remain valid until the writer
+	 * overruns them, which is detected by consume().
+	 *
+	 * @param first Set to the beginning of the first span.
+	 * @param firstSize Set to the size of the first span in bytes.
+	 * @param second Set to the beginning of the second span.
+	 * @param secondSize Set to the size of the second span in bytes, which is 0 if the unread bytes do not wrap.
+	 * @return The total amount of unread bytes.
+	 */
+	std::size_t peek(const Byte*& first, std::size_t& firstSize, const Byte*& second, std::size_t& secondSize);
+
+	/**
+	 * \brief Advance the cursor past bytes obtained with peek()
+	 *
+	 * @param size The amount of bytes to advance.
+	 * @return False if the writer overran the bytes while they were accessed, in which case whatever was derived from them
+	 * must be discarded. The cursor is moved to the oldest valid item either way.
+	 */
+	bool consume(std::size_t size);
+
+	/**
+	 * \brief Get the amount of overruns detected
+	 *
+	 * @return The amount of times the writer overran this reader.
+	 */
+	std::size_t getOverruns();
+
+	/**
+	 * \brief Get the amount of bytes lost to overruns
+	 *
+	 * @return The amount of bytes skipped by this reader because of overruns.
+	 */
+	uint64_t getLostBytes();
+private:
+	boost::interprocess::shared_memory_object sharedMemory;
+	boost::interprocess::mapped_region region;
+	const SerialBasicSharedRingHeader* header;
+	const Byte* data;
+	uint64_t capacity;
+	uint64_t mask;
+	uint64_t cursor;
+	std::size_t overruns;
+	uint64_t lostBytes;
+	uint64_t getWriteSequence();
+	bool validate();
+};
+
+template <class Type, class Config>
+SerialBasicSharedRingWriter<Type, Config>::SerialBasicSharedRingWriter(SerialBasic<Type, Config>& port, const std::string& name,
+	std::size_t capacity) : port(port), name(name) {
+
+		// verify capacity
+		if (capacity == 0 || (capacity&(capacity-1)) != 0 || capacity%sizeof(Type) != 0)
+			throw boost::system::system_error(boost::system::errc::make_error_code(
+				boost::system::errc::invalid_argument));
+
+		// create shared memory object
+		boost::interprocess::shared_memory_object::remove(name.c_str());
+		sharedMemory = boost::interprocess::shared_memory_object(boost::interprocess::create_only, name.c_str(),
+			boost::interprocess::read_write);
+		sharedMemory.truncate(sizeof(SerialBasicSharedRingHeader)+capacity);
+		region = boost::interprocess::mapped_region(sharedMemory, boost::interprocess::read_write);
+
+		// initialize header, with the magic set last so readers never see a partial header
+		header = new (region.get_address()) SerialBasicSharedRingHeader();
+		header->capacity = capacity;
+		header->reserveSequence.store(0, std::memory_order_relaxed);
+		header->writeSequence.store(0, std::memory_order_relaxed);
+		header->magic.store(SerialBasicSharedRingHeader::MAGIC, std::memory_order_release);
+		data = (Byte*)(header+1);
+
+		// publish received chunks
+		receiveHandlerId = port.addReceiveHandler([this](const Byte* chunk, std::size_t size)->void{
+			publish(chunk, size);
+		});
+}
+
+template <class Type, class Config>
+SerialBasicSharedRingWriter<Type, Config>::~SerialBasicSharedRingWriter() {
+	port.removeReceiveHandler(receiveHandlerId);
+	boost::interprocess::shared_memory_object::remove(name.c_str());
+}
+
+template <class Type, class Config>
+void SerialBasicSharedRingWriter<Type, Config>::publish(const Byte* data, std::size_t size) {
+	uint64_t capacity = header->capacity;
+	uint64_t sequence = header->writeSequence.load(std::memory_order_relaxed);
+
+	// only the last capacity bytes of a large chunk survive
+	if (size > capacity) {
+		sequence += size-capacity;
+		data += size-capacity;
+		size = capacity;
+	}
+
+	// reserve the bytes before they are overwritten, so readers can detect overruns
+	header->reserveSequence.store(sequence+size, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	std::size_t position = sequence&(capacity-1);
+	std::size_t firstSize = (capacity-position < size) ? capacity-position : size;
+	std::memcpy(this->data+position, data, firstSize);
+	std::memcpy(this->data, data+firstSize, size-firstSize);
+	header->writeSequence.store(sequence+size, std::memory_order_release);
+}
+
+template <class Type>
+SerialBasicSharedRingReader<Type>::SerialBasicSharedRingReader(const std::string& name) :
+	sharedMemory(boost::interprocess::open_only, name.c_str(), boost::interprocess::read_only),
+	region(sharedMemory, boost::interprocess::read_only), overruns(0), lostBytes(0) {
+		header = (const SerialBasicSharedRingHeader*)region.get_address();
+		if (region.get_size() < sizeof(SerialBasicSharedRingHeader) ||
+			header->magic.load(std::memory_order_acquire) != SerialBasicSharedRingHeader::MAGIC)
+			throw boost::system::system_error(boost::system::errc::make_error_code(
+				boost::system::errc::invalid_argument));
+
+		// the capacity is taken once, and only if the ring it describes lies within the shared memory object, since
+		// every access is masked by it
+		capacity = header->capacity;
+		if (capacity == 0 || (capacity&(capacity-1)) != 0 || capacity%sizeof(Type) != 0 ||
+			capacity > region.get_size()-sizeof(SerialBasicSharedRingHeader))
+			throw boost::system::system_error(boost::system::errc::make_error_code(
+				boost::system::errc::invalid_argument));
+		data = (const Byte*)(header+1);
+		mask = capacity-1;
+		cursor = getWriteSequence();
+		cursor -= cursor%sizeof(Type);
+}
+
+template <class Type>
+std::size_t SerialBasicSharedRingReader<Type>::available() {
+	uint64_t end = getWriteSequence();
+	if (end-cursor > capacity) {
+		validate();
+		end = getWriteSequence();
+	}
+	return (std::size_t)((end-cursor)/sizeof(Type));
+}
+
+template <class Type>
+template <class BeginIterator>
+std::size_t SerialBasicSharedRingReader<Type>::read(BeginIterator beginIterator, std::size_t size) {
+	std::size_t itemsToTransfer = available();
+	itemsToTransfer = (itemsToTransfer < size) ? itemsToTransfer : size;
+	for (std::size_t i = 0; i < itemsToTransfer; i++) {
+		Type item;
+		Byte* itemBytes = (Byte*)&item;
+		for (std::size_t j = 0; j < sizeof(Type); j++)
+			itemBytes[j] = data[(cursor+j)&mask];
+
+		// an item copied while the writer overran it is torn, thus stop at the first torn item
+		if (validate() == false)
+			return i;
+		*(beginIterator++) = item;
+		cursor += sizeof(Type);
+	}
+	return itemsToTransfer;
+}
+
+template <class Type>
+std::size_t SerialBasicSharedRingReader<Type>::peek(const Byte*& first, std::size_t& firstSize,
+	const Byte*& second, std::size_t& secondSize) {
+	std::size_t size = available()*sizeof(Type);
+	std::size_t position = (std::size_t)(cursor&mask);
+	first = data+position;
+	firstSize = ((std::size_t)capacity-position < size) ? (std::size_t)capacity-position : size;
+	second = data;
+	secondSize = size-firstSize;
+	return size;
+}
+
+template <class Type>
+bool SerialBasicSharedRingReader<Type>::consume(std::size_t size) {
+	if (validate() == false)
+		return false;
+	cursor += size;
+	return true;
+}
+
+template <class Type>
+std::size_t SerialBasicSharedRingReader<Type>::getOverruns() {
+	return overruns;
+}
+
+template <class Type>
+uint64_t SerialBasicSharedRingReader<Type>::getLostBytes() {
+	return lostBytes;
+}
+
+template <class Type>
+uint64_t SerialBasicSharedRingReader<Type>::getWriteSequence() {
+	return header->writeSequence.load(std::memory_order_acquire);
+}
+
+template <class Type>
+bool SerialBasicSharedRingReader<Type>::validate() {
+
+	// the bytes after cursor are intact as long as the writer has not reserved beyond cursor+capacity
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t reserved = header->reserveSequence.load(std::memory_order_relaxed);
+	if (reserved-cursor <= capacity)
+		return true;
+
+	// skip to the oldest item that is still intact
+	uint64_t oldest = reserved-capacity;
+	oldest += (sizeof(Type)-oldest%sizeof(Type))%sizeof(Type);
+	overruns++;
+	lostBytes += oldest-cursor;
+	cursor = oldest;
+	return false;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,500 @@
+#ifndef SERIAL_BASIC_SPILL_QUEUE_H_
+#define SERIAL_BASIC_SPILL_QUEUE_H_
+
+#include "SerialBasic.h"
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <deque>
+#include <map>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <cstring>
+
+/**
+ * @file SerialBasicSpillQueue.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicSpillQueue;
+
+/**
+ * \brief An outgoing message queue that holds messages while a serial link is down, spilling them to disk
+ *
+ * Messages are written to the SerialBasic object immediately while the queue is empty and the link is up. Otherwise
+ * they are queued and written in order by flush(), e.g. once the link is up again. Queued messages are held in memory
+ * up to a memory threshold, beyond which every queued message is moved to segment files that are memory-mapped and
+ * only ever appended to, named path.0, path.1, etc. Messages in segment files survive process restarts: a new
+ * SerialBasicSpillQueue object with the same path replays them, up to the last intact record of a segment file that
+ * is truncated or corrupt. Messages still in memory are spilled when the SerialBasicSpillQueue object is destroyed.
+ *
+ * Queued messages can be pruned by age, and the total size of queued messages can be limited, in which case the
+ * messages of lowest priority are dropped first, oldest first. The progress of flush() is saved in the segment
+ * files, thus after a crash at most one message is written twice.
+ */
+template <class Type, class Config>
+class SerialBasicSpillQueue {
+public:
+	typedef typename SerialBasic<Type, Config>::Byte Byte;
+
+	/**
+	 * \brief Open the queue, replaying the messages spilled to path by a previous SerialBasicSpillQueue object
+	 *
+	 * @param path The path from which the names of the segment files are formed.
+	 * @param memoryThreshold The maximum size in bytes of the messages held in memory.
+	 * @param segmentSize The size in bytes of a segment file.
+	 * @throw boost::interprocess::interprocess_exception Thrown if a segment file could not be mapped.
+	 */
+	SerialBasicSpillQueue(const std::string& path, std::size_t memoryThreshold = 65536,
+		std::size_t segmentSize = 1 << 20);
+
+	/**
+	 * \brief Spill the messages held in memory, so that they are replayed after a restart
+	 */
+	~SerialBasicSpillQueue();
+
+	/**
+	 * \brief Write a message, or queue it if earlier messages are queued or writing fails (blocking)
+	 *
+	 * @param port The SerialBasic object.
+	 * @param items The items of the message.
+	 * @param size The amount of items.
+	 * @param priority The priority of the message, which only affects which messages are pruned first.
+	 * @return True if the message was written, false if it was queued.
+	 */
+	bool write(SerialBasic<Type, Config>& port, const Type* items, std::size_t size, uint8_t priority = 0);
+
+	/**
+	 * \brief Queue a message without attempting to write it
+	 *
+	 * @param items The items of the message.
+	 * @param size The amount of items.
+	 * @param priority The priority of the message.
+	 */
+	void push(const Type* items, std::size_t size, uint8_t priority = 0);
+
+	/**
+	 * \brief Write the queued messages in order, back to back, until the queue is empty or writing fails (blocking)
+	 *
+	 * @param port The SerialBasic object.
+	 * @return The amount of messages written.
+	 */
+	std::size_t flush(SerialBasic<Type, Config>& port);
+
+	/**
+	 * \brief Set how queued messages are pruned
+	 *
+	 * Messages older than maxAge are dropped when the queue is flushed. While the total size of the queued messages
+	 * exceeds maxSize, the oldest message of the lowest priority is dropped.
+	 *
+	 * @param maxAge The maximum age of a message in milliseconds. 0 never drops messages by age.
+	 * @param maxSize The maximum total size of the queued messages in bytes. 0 never drops messages by size.
+	 */
+	void setPruning(uint64_t maxAge, uint64_t maxSize);
+
+	/**
+	 * \brief Get the amount of queued messages
+	 *
+	 * @return The amount of queued messages.
+	 */
+	std::size_t getQueuedMessages();
+
+	/**
+	 * \brief Get the amount of messages dropped by pruning
+	 *
+	 * @return The amount of dropped messages.
+	 */
+	uint64_t getDroppedMessages();
+
+	/**
+	 * \brief Get boost error code
+	 *
+	 * @return The boost error code of the last failed write.
+	 */
+	boost::system::error_code& getErrorCode();
+private:
+	const static uint32_t MAGIC = 0x53425351;
+	struct SegmentHeader {
+		uint32_t magic;
+		uint32_t reserved;
+		uint64_t capacity;
+		uint64_t readOffset;
+		uint64_t writeOffset;
+	};
+	struct RecordHeader {
+		uint32_t size;
+		uint8_t priority;
+		uint8_t dropped;
+		uint16_t reserved;
+		uint64_t timestamp;
+	};
+	struct Message {
+		std::vector<Byte> data;
+		uint8_t priority;
+		bool dropped;
+		uint64_t timestamp;
+	};
+	const static std::size_t MEMORY = (std::size_t)-1;
+	struct Position {
+		std::size_t segment;
+		uint64_t offset;
+	};
+	struct Segment {
+		boost::interprocess::file_mapping file;
+		boost::interprocess::mapped_region region;
+		SegmentHeader* header;
+	};
+	boost::mutex mutex;
+	std::string path;
+	std::size_t memoryThreshold;
+	std::size_t segmentSize;
+	std::deque<Message> messages;
+	uint64_t firstSequence;
+	std::size_t memorySize;
+	std::deque<std::unique_ptr<Segment> > segments;
+	std::size_t queuedMessages;
+	uint64_t queuedSize;
+	uint64_t maxAge;
+	uint64_t maxSize;
+	uint64_t droppedMessages;
+	std::map<uint8_t, std::deque<Position> > pruneIndex;
+	boost::system::error_code errorCode;
+	std::string segmentPath(std::size_t index);
+	void addSegment(std::size_t minimumSize);
+	void append(const Byte* data, std::size_t size, uint8_t priority, uint64_t timestamp);
+	void spill();
+	void pruneSize();
+	void unindex(uint8_t priority);
+	void removeSegments();
+	static uint64_t now();
+	static std::size_t recordSize(std::size_t size);
+	static RecordHeader* record(Segment& segment, uint64_t offset);
+};
+
+template <class Type, class Config>
+SerialBasicSpillQueue<Type, Config>::SerialBasicSpillQueue(const std::string& path, std::size_t memoryThreshold,
+	std::size_t segmentSize) : path(path), memoryThreshold(memoryThreshold), segmentSize(segmentSize),
+	firstSequence(0), memorySize(0), queuedMessages(0), queuedSize(0), maxAge(0), maxSize(0), droppedMessages(0) {
+
+		// map the segments left by a previous object, counting their pending messages
+		for (std::size_t index = 0; std::ifstream(segmentPath(index).c_str()).good(); index++) {
+			std::unique_ptr<Segment> segment(new Segment());
+			segment->file = boost::interprocess::file_mapping(segmentPath(index).c_str(),
+				boost::interprocess::read_write);
+			segment->region = boost::interprocess::mapped_region(segment->file, boost::interprocess::read_write);
+			segment->header = (SegmentHeader*)segment->region.get_address();
+			if (segment->region.get_size() < sizeof(SegmentHeader) || segment->header->magic != MAGIC ||
+				segment->header->capacity != segment->region.get_size() ||
+				segment->header->readOffset < sizeof(SegmentHeader) ||
+				segment->header->readOffset > segment->header->writeOffset ||
+				segment->header->writeOffset > segment->header->capacity)
+				break;
+			for (uint64_t offset = segment->header->readOffset; offset < segment->header->writeOffset;
+				offset += recordSize(record(*segment, offset)->size)) {
+
+				// a truncated or corrupt record ends the segment at the last intact record
+				if (offset%8 != 0 || segment->header->writeOffset-offset < sizeof(RecordHeader) ||
+					segment->header->writeOffset-offset < recordSize(record(*segment, offset)->size)) {
+					segment->header->writeOffset = offset;
+					break;
+				}
+				RecordHeader* recordHeader = record(*segment, offset);
+				if (recordHeader->dropped == 0) {
+					queuedMessages++;
+					queuedSize += recordHeader->size;
+					pruneIndex[recordHeader->priority].push_back(Position{segments.size(), offset});
+				}
+			}
+			segments.push_back(std::move(segment));
+		}
+		if (queuedMessages == 0)
+			removeSegments();
+}
+
+template <class Type, class Config>
+SerialBasicSpillQueue<Type, Config>::~SerialBasicSpillQueue() {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	try {
+		spill();
+	} catch (boost::interprocess::interprocess_exception&) {
+	}
+}
+
+template <class Type, class Config>
+bool SerialBasicSpillQueue<Type, Config>::write(SerialBasic<Type, Config>& port, const Type* items, std::size_t size,
+	uint8_t priority) {
+	{
+		boost::unique_lock<boost::mutex> scoped_lock(mutex);
+		if (queuedMessages == 0) {
+			try {
+				port.write(items, size);
+				return true;
+			} catch (boost::system::system_error& e) {
+				errorCode = e.code();
+			}
+		}
+	}
+	push(items, size, priority);
+	return false;
+}
+
+template <class Type, class Config>
+void SerialBasicSpillQueue<Type, Config>::push(const Type* items, std::size_t size, uint8_t priority) {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	const Byte* data = (const Byte*)items;
+	std::size_t dataSize = size*sizeof(Type);
+
+	// once any message is spilled, later messages are appended to the segments as well, so the order is kept
+	if (segments.empty() && memorySize+dataSize > memoryThreshold)
+		spill();
+	if (segments.empty()) {
+		Message message;
+		message.data.assign(data, data+dataSize);
+		message.priority = priority;
+		message.dropped = false;
+		message.timestamp = now();
+		messages.push_back(message);
+		pruneIndex[priority].push_back(Position{MEMORY, firstSequence+messages.size()-1});
+		memorySize += dataSize;
+	} else {
+		append(data, dataSize, priority, now());
+	}
+	queuedMessages++;
+	queuedSize += dataSize;
+	pruneSize();
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicSpillQueue<Type, Config>::flush(SerialBasic<Type, Config>& port) {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	uint64_t oldestTimestamp = (maxAge != 0 && now() > maxAge) ? now()-maxAge : 0;
+	std::size_t writtenMessages = 0;
+	try {
+		while (messages.empty() == false) {
+			Message& message = messages.front();
+			if (message.dropped == false) {
+				if (message.timestamp >= oldestTimestamp) {
+					port.write((const Type*)message.data.data(), message.data.size()/sizeof(Type));
+					writtenMessages++;
+				} else {
+					droppedMessages++;
+				}
+				queuedMessages--;
+				queuedSize -= message.data.size();
+				memorySize -= message.data.size();
+				unindex(message.priority);
+			}
+			messages.pop_front();
+			firstSequence++;
+		}
+		for (auto segment = segments.begin(); segment != segments.end(); segment++) {
+			SegmentHeader* header = (*segment)->header;
+			while (header->readOffset < header->writeOffset) {
+				RecordHeader* recordHeader = record(**segment, header->readOffset);
+				if (recordHeader->dropped == 0) {
+					if (recordHeader->timestamp >= oldestTimestamp) {
+						port.write((const Type*)(recordHeader+1), recordHeader->size/sizeof(Type));
+						writtenMessages++;
+					} else {
+						droppedMessages++;
+					}
+					queuedMessages--;
+					queuedSize -= recordHeader->size;
+					unindex(recordHeader->priority);
+				}
+				header->readOffset += recordSize(recordHeader->size);
+			}
+		}
+	} catch (boost::system::system_error& e) {
+		errorCode = e.code();
+	}
+
+	// the segments are only removed once every spilled message is written, so their names always start at path.0
+	if (queuedMessages == 0 && segments.empty() == false)
+		removeSegments();
+	return writtenMessages;
+}
+
+template <class Type, class Config>
+void SerialBasicSpillQueue<Type, Config>::setPruning(uint64_t maxAge, uint64_t maxSize) {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	this->maxAge = maxAge;
+	this->maxSize = maxSize;
+	pruneSize();
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicSpillQueue<Type, Config>::getQueuedMessages() {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	return queuedMessages;
+}
+
+template <class Type, class Config>
+uint64_t SerialBasicSpillQueue<Type, Config>::getDroppedMessages() {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	return droppedMessages;
+}
+
+template <class Type, class Config>
+boost::system::error_code& SerialBasicSpillQueue<Type, Config>::getErrorCode() {
+	boost::unique_lock<boost::mutex> scoped_lock(mutex);
+	return errorCode;
+}
+
+template <class Type, class Config>
+std::string SerialBasicSpillQueue<Type, Config>::segmentPath(std::size_t index) {
+	std::stringstream ss;
+	ss << path << "." << index;
+	return ss.str();
+}
+
+template <class Type, class Config>
+void SerialBasicSpillQueue<Type, Config>::addSegment(std::size_t minimumSize) {
+	std::size_t capacity = (minimumSize+sizeof(SegmentHeader) > segmentSize) ?
+		minimumSize+sizeof(SegmentHeader) :
+		segmentSize;
+	std::string name = segmentPath(segments.size());
+	{
+		std::filebuf file;
+		file.open(name.c_str(), std::ios_base::in|std::ios_base::out|std::ios_base::trunc|std::ios_base::binary);
+		file.pubseekoff((std::streamoff)capacity-1, std::ios_base::beg);
+		file.sputc(0);
+	}
+	std::unique_ptr<Segment> segment(new Segment());
+	segment->file = boost::interprocess::file_mapping(name.c_str(), boost::interprocess::read_write);
+	segment->region = boost::interprocess::mapped_region(segment->file, boost::interprocess::read_write);
+	segment->header = (SegmentHeader*)segment->region.get_address();
+	segment->header->capacity = capacity;
+	segment->header->readOffset = sizeof(SegmentHeader);
+	segment->header->writeOffset = sizeof(SegmentHeader);
+	segment->header->magic = MAGIC;
+	segments.push_back(std::move(segment));
+}
+
+template <class Type, class Config>
+void SerialBasicSpillQueue<Type, Config>::append(const Byte* data, std::size_t size, uint8_t priority,
+	uint64_t timestamp) {
+	if (segments.empty() ||
+		segments.back()->header->writeOffset+recordSize(size) > segments.back()->header->capacity)
+		addSegment(recordSize(size));
+	Segment& segment = *segments.back();
+	RecordHeader* recordHeader = record(segment, segment.header->writeOffset);
+	pruneIndex[priority].push_back(Position{segments.size()-1, segment.header->writeOffset});
+	recordHeader->size = (uint32_t)size;
+	recordHeader->priority = priority;
+	recordHeader->dropped = 0;
+	recordHeader->reserved = 0;
+	recordHeader->timestamp = timestamp;
+	std::memcpy(recordHeader+1, data, size);
+
+	// the record is only published once it is complete
+	segment.header->writeOffset += recordSize(size);
+}
+
+template <class Type, class Config>
+void SerialBasicSpillQueue<Type, Config>::spill() {
+	if (messages.empty())
+		return;
+
+	// messages are only held in memory while there are no segments, thus every position refers to memory, and the
+	// positions of the messages are added again as they are appended
+	pruneIndex.clear();
+	while (messages.empty() == false) {
+		Message& message = messages.front();
+		if (message.dropped == false) {
+			append(message.data.data(), message.data.size(), message.priority, message.timestamp);
+			memorySize -= message.data.size();
+		}
+		messages.pop_front();
+		firstSequence++;
+	}
+}
+
+template <class Type, class Config>
+void SerialBasicSpillQueue<Type, Config>::pruneSize() {
+	while (maxSize != 0 && queuedSize > maxSize && pruneIndex.empty() == false) {
+
+		// the positions of each priority are in the order of the queue, thus the oldest message of the lowest
+		// priority is the first position of the first priority
+		auto lowest = pruneIndex.begin();
+		Position& position = lowest->second.front();
+		if (position.segment == MEMORY) {
+
+			// the message is only marked, since erasing it would move the messages after it
+			Message& message = messages[(std::size_t)(position.offset-firstSequence)];
+			message.dropped = true;
+			queuedSize -= message.data.size();
+			memorySize -= message.data.size();
+			std::vector<Byte>().swap(message.data);
+		} else {
+			RecordHeader* recordHeader = record(*segments[position.segment], position.offset);
+			recordHeader->dropped = 1;
+			queuedSize -= recordHeader->size;
+		}
+		unindex(lowest->first);
+		queuedMessages--;
+		droppedMessages++;
+	}
+}
+
+template <class Type, class Config>
+void SerialBasicSpillQueue<Type, Config>::unindex(uint8_t priority) {
+
+	// a message leaves the queue either when it is the oldest of its priority, or when it is pruned as such
+	auto positions = pruneIndex.find(priority);
+	positions->second.pop_front();
+	if (positions->second.empty())
+		pruneIndex.erase(positions);
+}
+
+template <class Type, class Config>
+void SerialBasicSpillQueue<Type, Config>::removeSegments() {
+	std::size_t segmentCount = segments.size();
+	segments.clear();
+	for (std::size_t index = 0; std::ifstream(segmentPath(index).c_str()).good() || index < segmentCount; index++)
+		boost::interprocess::file_mapping::remove(segmentPath(index).c_str());
+}
+
+template <class Type, class Config>
+uint64_t SerialBasicSpillQueue<Type, Config>::now() {
+
+	// the system clock is used, since timestamps must remain meaningful after a restart
+	return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+template <class Type, class Config>
+std::size_t SerialBasicSpillQueue<Type, Config>::recordSize(std::size_t size) {
+	return (sizeof(RecordHeader)+size+7) & ~(std::size_t)7;
+}
+
+template <class Type, class Config>
+typename SerialBasicSpillQueue<Type, Config>::RecordHeader* SerialBasicSpillQueue<Type, Config>::record(
+	Segment& segment, uint64_t offset) {
+	return (RecordHeader*)((Byte*)segment.region.get_address()+offset);
+}
+
+#endif
\ No newline at end of file
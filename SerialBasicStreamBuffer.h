@@ -0,0 +1,201 @@
+#ifndef SERIAL_BASIC_STREAM_BUFFER_H_
+#define SERIAL_BASIC_STREAM_BUFFER_H_
+
+#include "SerialBasic.h"
+#include <streambuf>
+#include <cstring>
+
+/**
+ * @file SerialBasicStreamBuffer.h
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ */
+
+
+template <class Type = uint8_t, class Config = SerialBasicConfig<> > class SerialBasicStreamBuffer;
+
+/**
+ * \brief A std::streambuf over a SerialBasic object, so that iostreams can read and write serial data
+ *
+ * The get area is the SerialBasic object's read buffer itself, accessed in place with SerialBasic::peek(), thus
+ * extracting characters does not copy them out of the read buffer first. Characters are consumed from the read buffer
+ * when the get area is refilled or the stream is synchronized. The put area is an array of Config::WRITE_BUFFER_SIZE
+ * characters that is written with a single SerialBasic::write() when it is full or the stream is flushed. Bulk
+ * extraction and insertion are done with memcpy, and insertions larger than the put area are written directly.
+ *
+ * While a SerialBasicStreamBuffer object is in use, the SerialBasic object should not be read by other means (e.g.
+ * read() or drain()). Only SerialBasic objects whose Type is a single byte are supported.
+ */
+template <class Type, class Config>
+class SerialBasicStreamBuffer : public std::streambuf {
+public:
+
+	/**
+	 * \brief Create a stream buffer over a SerialBasic object
+	 *
+	 * @param port The SerialBasic object. It must outlive the SerialBasicStreamBuffer object.
+	 * @param timeout The maximum time in milliseconds to wait for data when the get area is empty, after which the
+	 * stream reaches its end.
+	 */
+	SerialBasicStreamBuffer(SerialBasic<Type, Config>& port, uint32_t timeout = 1000);
+
+	/**
+	 * \brief Consume the extracted characters and write the put area
+	 */
+	~SerialBasicStreamBuffer();
+protected:
+	int_type underflow();
+	std::streamsize showmanyc();
+	std::streamsize xsgetn(char_type* characters, std::streamsize size);
+	int_type overflow(int_type character);
+	std::streamsize xsputn(const char_type* characters, std::streamsize size);
+	int sync();
+private:
+	static_assert(sizeof(Type) == 1, "SerialBasicStreamBuffer requires a Type of a single byte");
+	const static std::size_t PUT_AREA_SIZE = Config::WRITE_BUFFER_SIZE;
+	SerialBasic<Type, Config>& port;
+	uint32_t timeout;
+	char_type putArea[PUT_AREA_SIZE];
+	void consumeGetArea();
+	bool writePutArea();
+};
+
+template <class Type, class Config>
+SerialBasicStreamBuffer<Type, Config>::SerialBasicStreamBuffer(SerialBasic<Type, Config>& port, uint32_t timeout) :
+	port(port), timeout(timeout) {
+		setg(NULL, NULL, NULL);
+		setp(putArea, putArea+PUT_AREA_SIZE);
+}
+
+template <class Type, class Config>
+SerialBasicStreamBuffer<Type, Config>::~SerialBasicStreamBuffer() {
+	consumeGetArea();
+	writePutArea();
+}
+
+template <class Type, class Config>
+typename SerialBasicStreamBuffer<Type, Config>::int_type SerialBasicStreamBuffer<Type, Config>::underflow() {
+	if (gptr() < egptr())
+		return traits_type::to_int_type(*gptr());
+
+	// the characters of the get area were all extracted, thus the get area is refilled from the read buffer
+	consumeGetArea();
+	const typename SerialBasic<Type, Config>::Byte* data;
+	std::size_t size = port.peek(data);
+	if (size == 0 && port.wait(timeout) != 0)
+		size = port.peek(data);
+	if (size == 0)
+		return traits_type::eof();
+	char_type* begin = (char_type*)data;
+	setg(begin, begin, begin+size);
+	return traits_type::to_int_type(*gptr());
+}
+
+template <class Type, class Config>
+std::streamsize SerialBasicStreamBuffer<Type, Config>::showmanyc() {
+	std::streamsize size = (std::streamsize)(egptr()-gptr());
+	if (size == 0)
+		size = (std::streamsize)port.available();
+	return size;
+}
+
+template <class Type, class Config>
+std::streamsize SerialBasicStreamBuffer<Type, Config>::xsgetn(char_type* characters, std::streamsize size) {
+	std::streamsize extractedSize = 0;
+	while (extractedSize < size) {
+		if (gptr() == egptr() && traits_type::eq_int_type(underflow(), traits_type::eof()))
+			break;
+		std::streamsize copySize = (egptr()-gptr() < size-extractedSize) ? egptr()-gptr() : size-extractedSize;
+		std::memcpy(characters+extractedSize, gptr(), (std::size_t)copySize);
+		gbump((int)copySize);
+		extractedSize += copySize;
+	}
+	return extractedSize;
+}
+
+template <class Type, class Config>
+typename SerialBasicStreamBuffer<Type, Config>::int_type SerialBasicStreamBuffer<Type, Config>::overflow(
+	int_type character) {
+	if (writePutArea() == false)
+		return traits_type::eof();
+	if (traits_type::eq_int_type(character, traits_type::eof()))
+		return traits_type::not_eof(character);
+	*pptr() = traits_type::to_char_type(character);
+	pbump(1);
+	return character;
+}
+
+template <class Type, class Config>
+std::streamsize SerialBasicStreamBuffer<Type, Config>::xsputn(const char_type* characters, std::streamsize size) {
+	if (size <= epptr()-pptr()) {
+		std::memcpy(pptr(), characters, (std::size_t)size);
+		pbump((int)size);
+		return size;
+	}
+
+	// characters that do not fit are written directly, rather than staged in the put area
+	if (writePutArea() == false)
+		return 0;
+	if (size >= (std::streamsize)PUT_AREA_SIZE) {
+		try {
+			port.write((const Type*)characters, (std::size_t)size);
+		} catch (boost::system::system_error&) {
+			return 0;
+		}
+		return size;
+	}
+	std::memcpy(pptr(), characters, (std::size_t)size);
+	pbump((int)size);
+	return size;
+}
+
+template <class Type, class Config>
+int SerialBasicStreamBuffer<Type, Config>::sync() {
+	consumeGetArea();
+	return writePutArea() ? 0 : -1;
+}
+
+template <class Type, class Config>
+void SerialBasicStreamBuffer<Type, Config>::consumeGetArea() {
+
+	// the characters that were not extracted yet remain in place as the get area
+	port.consume((std::size_t)(gptr()-eback()));
+	setg(gptr(), gptr(), egptr());
+}
+
+template <class Type, class Config>
+bool SerialBasicStreamBuffer<Type, Config>::writePutArea() {
+	std::size_t size = (std::size_t)(pptr()-pbase());
+	setp(putArea, putArea+PUT_AREA_SIZE);
+	if (size == 0)
+		return true;
+	try {
+		port.write((const Type*)putArea, size);
+	} catch (boost::system::system_error&) {
+		return false;
+	}
+	return true;
+}
+
+#endif
\ No newline at end of file
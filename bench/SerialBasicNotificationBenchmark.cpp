@@ -0,0 +1,142 @@
+#include "../SerialBasic.h"
+#include <pty.h>
+#include <unistd.h>
+#include <termios.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/**
+ * @file SerialBasicNotificationBenchmark.cpp
+ * @author  Andrew Powell <andrew.powell@temple.edu>
+ * @version 1.0
+ *
+ * @section LICENSE
+ *
+ * Copyright (C) 2014  Andrew Powell
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 3 of
+ * the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * Distributed under the Boost Software License, Version 1.0.
+ *    (See accompanying file LICENSE_1_0.txt or copy at
+ *          http://www.boost.org/LICENSE_1_0.txt)
+ *
+ * @section DESCRIPTION
+ *
+ * Measures the wakeups per second of a consumer blocked in SerialBasic::wait() against the latency of the items it
+ * receives, for several notification windows (see SerialBasic::setNotification()). A writer thread sends single bytes
+ * at a fixed interval into a pseudo terminal, whose other end is opened by a SerialBasic object. The latency of an item
+ * is the time from its write to the wakeup of the consumer that read it.
+ *
+ * Only available on operating systems with pseudo terminals (e.g. Linux). Built from this directory with e.g.
+ *
+ *	g++ -std=c++11 -O2 SerialBasicNotificationBenchmark.cpp -o SerialBasicNotificationBenchmark -lboost_thread
+ *		-lboost_system -lpthread -lutil
+ *
+ * and run with the amount of items and the interval between them in microseconds, which default to 1000 and 500.
+ */
+
+typedef std::chrono::steady_clock Clock;
+
+struct Result {
+	uint64_t wakeups;
+	double wakeupsPerSecond;
+	double meanLatency;
+	double maxLatency;
+};
+
+static int64_t microseconds(Clock::time_point time) {
+	return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+static Result run(std::size_t minimumItems, uint32_t maximumDelay, std::size_t items, uint32_t interval) {
+	int master, slave;
+	char name[64];
+	if (openpty(&master, &slave, name, NULL, NULL) != 0) {
+		std::perror("openpty");
+		std::exit(1);
+	}
+	struct termios attributes;
+	tcgetattr(slave, &attributes);
+	cfmakeraw(&attributes);
+	tcsetattr(slave, TCSANOW, &attributes);
+
+	Result result = Result();
+	{
+		Serial port(std::string(name), 57600);
+		port.setNotification(minimumItems, maximumDelay);
+
+		// the write time of every item, read by the consumer once the item arrived
+		std::unique_ptr<std::atomic<int64_t>[]> writeTimes(new std::atomic<int64_t>[items]);
+		Clock::time_point start = Clock::now();
+		boost::thread writer([master, items, interval, start, &writeTimes]()->void{
+			for (std::size_t i = 0; i < items; i++) {
+				uint8_t item = (uint8_t)i;
+				writeTimes[i].store(microseconds(Clock::now()));
+				if (::write(master, &item, 1) != 1)
+					return;
+				std::this_thread::sleep_until(start+std::chrono::microseconds((int64_t)interval*(i+1)));
+			}
+		});
+
+		// the consumer wakes up, reads everything buffered, and waits again
+		std::vector<uint8_t> buffer(SerialBasicConfig<>::READ_BUFFER_SIZE);
+		std::size_t received = 0;
+		double totalLatency = 0;
+		while (received < items) {
+			if (port.wait(1000) == 0)
+				break;
+			int64_t now = microseconds(Clock::now());
+			result.wakeups++;
+			std::size_t size = port.read(buffer.data(), buffer.size());
+			for (std::size_t i = received; i < received+size && i < items; i++) {
+				double latency = (double)(now-writeTimes[i].load());
+				totalLatency += latency;
+				if (latency > result.maxLatency)
+					result.maxLatency = latency;
+			}
+			received += size;
+		}
+		double elapsed = (double)std::chrono::duration_cast<std::chrono::microseconds>(Clock::now()-start).count();
+		writer.join();
+		result.wakeupsPerSecond = result.wakeups*1000000.0/elapsed;
+		result.meanLatency = (received != 0) ? totalLatency/received : 0;
+	}
+	close(slave);
+	close(master);
+	return result;
+}
+
+int main(int argc, char** argv) {
+	std::size_t items = (argc > 1) ? (std::size_t)std::atol(argv[1]) : 1000;
+	uint32_t interval = (argc > 2) ? (uint32_t)std::atol(argv[2]) : 500;
+	const struct {
+		std::size_t minimumItems;
+		uint32_t maximumDelay;
+	} windows[] = {{1, 0}, {4, 1000}, {16, 2000}, {16, 10000}, {64, 10000}};
+
+	std::printf("%zu items, %u us apart\n", items, interval);
+	std::printf("%8s %10s %10s %12s %14s %14s\n", "N", "T (us)", "wakeups", "wakeups/s", "mean lat (us)",
+		"max lat (us)");
+	for (std::size_t i = 0; i < sizeof(windows)/sizeof(windows[0]); i++) {
+		Result result = run(windows[i].minimumItems, windows[i].maximumDelay, items, interval);
+		std::printf("%8zu %10u %10llu %12.0f %14.0f %14.0f\n", windows[i].minimumItems, windows[i].maximumDelay,
+			(unsigned long long)result.wakeups, result.wakeupsPerSecond, result.meanLatency, result.maxLatency);
+	}
+	return 0;
+}